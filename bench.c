@@ -0,0 +1,905 @@
+/**
+ * bench.c - Benchmark harness for ECE 361 hw5
+ *
+ * @file:               bench.c
+ * @author:             Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ * @version:    1.0
+ *
+ * @brief
+ * Generates synthetic temp_humid_data_t readings and times the BST operations and the
+ * sensor read loop.  Every measurement is printed as one JSON object per line so runs
+ * can be collected and compared by scripts (the I/O module prints its register state
+ * when initialized, so keep only the lines starting with '{').
+ *
+ * Usage: HW5_bench [-n readings] [-q queries] [-p sorted|reverse|random|clustered|all] [-s seed]
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <pthread.h>
+#include <sched.h>
+#include "bst.h"
+#include "bst_frozen.h"
+#include "bst_rcu.h"
+#include "bst_shard.h"
+#include "bst_snapshot.h"
+#include "colstore.h"
+#include "float_rndm.h"
+#include "ingest.h"
+#include "iom361_r2.h"
+#include "shuffle.h"
+#include "spsc_ring.h"
+#include "wal.h"
+
+// typedefs, enums and constants
+#define TEMP_RANGE_LOW  42.0
+#define TEMP_RANGE_HI   52.0
+#define HUMID_RANGE_LOW 72.6
+#define HUMID_RANGE_HI  87.3
+
+#define BASE_TIMESTAMP  1730419200  // 11/01/2024 00:00:00 UTC
+#define CLUSTER_MAX     256         // largest burst of readings in the clustered pattern
+#define RANGE_WINDOW    3600        // width of the range/aggregate query windows, in seconds
+#define CAPTURE_RING    4096        // samples per iom361_captureSensor1() burst
+#define SPSC_CAPACITY   4096        // readings in flight in the ring benchmark
+#define SPSC_BATCH      64          // readings per push/pop in the ring benchmark
+
+#define SNAPSHOT_PATH   "HW5_bench.snapshot"    // scratch file for the snapshot benchmark, removed afterwards
+#define WAL_PATH        "HW5_bench.wal"         // scratch log for the write-ahead log benchmark, removed afterwards
+#define WAL_GROUP       65536                   // readings per group commit in the log benchmark
+#define DUP_BURST       8                       // readings sharing each timestamp in the duplicate benchmark
+#define SHARD_WORKERS   4                       // shards (and ingest threads) in the sharded index benchmark
+#define RCU_READERS     4           // reader threads querying while the writer inserts
+#define FLEET_DEVICES   4           // emulated boards, one per thread, in the fleet benchmark
+
+// Reader side of the concurrent tree benchmark
+typedef struct {
+    rcu_tree_ptr_t tree;
+    const time_t* keys;
+    size_t queries;
+    atomic_bool* stop;
+    size_t done;
+    uint64_t acc;
+} rcu_reader_t;
+
+// One board of the sensor fleet benchmark
+typedef struct {
+    iom361_dev_t* dev;
+    size_t n;
+    uint64_t seed;
+    uint64_t acc;
+} fleet_worker_t;
+
+// Producer side of the ring benchmark
+typedef struct {
+    spsc_ring_ptr_t ring;
+    const temp_humid_data_t* data;
+    size_t n;
+} ring_producer_t;
+
+static const char* pattern_names[] = {"sorted", "reverse", "random", "clustered"};
+#define NUM_PATTERNS (sizeof(pattern_names) / sizeof(pattern_names[0]))
+
+// global variables
+static uint64_t rng_state;
+static volatile uint64_t sink;    // keeps results alive so the optimizer can't drop the work
+
+// Prototype functions
+static uint64_t next_rand(void);
+static double now_ns(void);
+static long peak_rss_kb(void);
+static void report(const char* bench, const char* pattern, size_t n, size_t ops, double ns, int height);
+static void generate(temp_humid_data_t* data, size_t n, int pattern);
+static void run_tree_benches(const char* pattern, temp_humid_data_t* data, size_t n, size_t queries);
+static void run_sensor_bench(size_t n);
+static void run_fleet_bench(size_t n);
+static void run_rand_bench(size_t n);
+static void run_date_bench(size_t n);
+static void run_ring_bench(const temp_humid_data_t* data, size_t n);
+static void run_shuffle_bench(const temp_humid_data_t* data, size_t n);
+static void run_ingest_bench(const temp_humid_data_t* data, size_t n);
+static void run_wal_bench(const temp_humid_data_t* data, size_t n);
+static void run_rcu_bench(const char* pattern, const temp_humid_data_t* data, size_t n);
+static void run_shard_bench(const char* pattern, const temp_humid_data_t* data, size_t n, size_t queries);
+static void run_dup_bench(const char* pattern, const temp_humid_data_t* data, size_t n, size_t queries);
+static int count_visitor(const temp_humid_data_t* data, void* ctx);
+
+int main(int argc, char* argv[]) {
+    size_t n = 1000000;
+    size_t queries = 1000000;
+    const char* pattern = "all";
+    uint64_t seed = 361;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            n = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-q") == 0 && i + 1 < argc) {
+            queries = strtoull(argv[++i], NULL, 10);
+        } else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            pattern = argv[++i];
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [-n readings] [-q queries] [-p sorted|reverse|random|clustered|all] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (n == 0 || n > INT32_MAX) {
+        fprintf(stderr, "FATAL(main): readings must be between 1 and %d\n", INT32_MAX);
+        return 1;
+    }
+    if (queries == 0) {
+        fprintf(stderr, "FATAL(main): queries must be at least 1\n");
+        return 1;
+    }
+
+    temp_humid_data_t* data = (temp_humid_data_t*)malloc(n * sizeof(temp_humid_data_t));
+    if (data == NULL) {
+        fprintf(stderr, "FATAL(main): Could not allocate %zu readings\n", n);
+        return 1;
+    }
+
+    int ran = 0;
+    for (size_t p = 0; p < NUM_PATTERNS; p++) {
+        if (strcmp(pattern, "all") != 0 && strcmp(pattern, pattern_names[p]) != 0) continue;
+        rng_state = seed;
+        float_rand_seed(seed);
+        generate(data, n, (int)p);
+        run_tree_benches(pattern_names[p], data, n, queries);
+        run_rcu_bench(pattern_names[p], data, n);
+        run_shard_bench(pattern_names[p], data, n, queries);
+        run_dup_bench(pattern_names[p], data, n, queries);
+        if (p == 0) {
+            run_ring_bench(data, n);
+            run_shuffle_bench(data, n);
+            run_ingest_bench(data, n);
+            run_wal_bench(data, n);
+        }
+        ran = 1;
+    }
+    if (!ran) {
+        fprintf(stderr, "FATAL(main): Unknown pattern %s\n", pattern);
+        free(data);
+        return 1;
+    }
+
+    float_rand_seed(seed);
+    run_sensor_bench(n);
+    run_fleet_bench(n);
+    run_rand_bench(n);
+    run_date_bench(n);
+    free(data);
+    return 0;
+}
+
+// xorshift64* - fixed seed keeps every run on the same data
+static uint64_t next_rand(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static long peak_rss_kb(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;     // kilobytes on Linux
+}
+
+static void report(const char* bench, const char* pattern, size_t n, size_t ops, double ns, int height) {
+    double ns_per_op = (ops > 0) ? ns / ops : 0.0;
+    double ops_per_sec = (ns > 0) ? ops * 1e9 / ns : 0.0;
+    printf("{\"bench\":\"%s\",\"pattern\":\"%s\",\"n\":%zu,\"ops\":%zu,\"ns_per_op\":%.2f,"
+           "\"ops_per_sec\":%.0f,\"height\":%d,\"peak_rss_kb\":%ld}\n",
+           bench, pattern, n, ops, ns_per_op, ops_per_sec, height, peak_rss_kb());
+    fflush(stdout);
+}
+
+static void generate(temp_humid_data_t* data, size_t n, int pattern) {
+    for (size_t i = 0; i < n; i++) {
+        data[i].timestamp = BASE_TIMESTAMP + (time_t)i;
+        data[i].temp = TEMP_RANGE_LOW + next_rand() % (uint32_t)(TEMP_RANGE_HI - TEMP_RANGE_LOW + 1);
+        data[i].humid = HUMID_RANGE_LOW + next_rand() % (uint32_t)(HUMID_RANGE_HI - HUMID_RANGE_LOW + 1);
+    }
+
+    switch (pattern) {
+        case 0:     // sorted: arrival order
+            break;
+
+        case 1:     // reverse
+            for (size_t i = 0; i < n / 2; i++) {
+                temp_humid_data_t tmp = data[i];
+                data[i] = data[n - 1 - i];
+                data[n - 1 - i] = tmp;
+            }
+            break;
+
+        case 2:     // random
+            shuffle_readings(data, n);
+            break;
+
+        case 3:     // clustered: bursts of same-second samples at random times
+            for (size_t i = 0; i < n; ) {
+                size_t burst = 1 + next_rand() % CLUSTER_MAX;
+                time_t at = BASE_TIMESTAMP + (time_t)(next_rand() % n);
+                for (size_t j = 0; j < burst && i < n; j++, i++) {
+                    data[i].timestamp = at;
+                }
+            }
+            break;
+    }
+}
+
+static int count_visitor(const temp_humid_data_t* data, void* ctx) {
+    *(uint64_t*)ctx += data->temp;
+    return 0;
+}
+
+static void run_tree_benches(const char* pattern, temp_humid_data_t* data, size_t n, size_t queries) {
+    int size = (int)n;
+    double start;
+    uint64_t acc = 0;
+
+    temp_humid_data_t* scratch = (temp_humid_data_t*)malloc(n * sizeof(temp_humid_data_t));
+    time_t* keys = (time_t*)malloc(queries * sizeof(time_t));
+    bst_node_ptr_t* nodes = (bst_node_ptr_t*)malloc(queries * sizeof(bst_node_ptr_t));
+    temp_humid_data_ptr_t* found = (temp_humid_data_ptr_t*)malloc(queries * sizeof(temp_humid_data_ptr_t));
+    if (scratch == NULL || keys == NULL || nodes == NULL || found == NULL) {
+        fprintf(stderr, "ERROR(run_tree_benches): Could not allocate buffers\n");
+        free(scratch);
+        free(keys);
+        free(nodes);
+        free(found);
+        return;
+    }
+
+    // Lookups hit existing timestamps in random order
+    for (size_t i = 0; i < queries; i++) {
+        keys[i] = data[next_rand() % n].timestamp;
+    }
+
+    // Construction
+    start = now_ns();
+    bst_node_ptr_t tree = create_tree(data, size);
+    report("create_tree", pattern, n, n, now_ns() - start, tree_height(tree));
+    destroy_tree(tree, NULL);
+
+    bst_arena_ptr_t arena = create_arena(0);
+    start = now_ns();
+    tree = NULL;
+    for (size_t i = 0; i < n; i++) {
+        insert_node_arena(&tree, data[i], arena);
+    }
+    report("insert_node_arena", pattern, n, n, now_ns() - start, tree_height(tree));
+    destroy_arena(arena);
+
+    memcpy(scratch, data, n * sizeof(temp_humid_data_t));
+    arena = create_arena(0);
+    start = now_ns();
+    tree = create_tree_sorted(scratch, size, arena);
+    report("create_tree_sorted", pattern, n, n, now_ns() - start, tree_height(tree));
+
+    // Same tree again with the sort and build spread over every CPU
+    memcpy(scratch, data, n * sizeof(temp_humid_data_t));
+    bst_arena_ptr_t parallel_arena = create_arena(0);
+    start = now_ns();
+    bst_node_ptr_t parallel = create_tree_parallel(scratch, size, parallel_arena, 0);
+    report("create_tree_parallel", pattern, n, n, now_ns() - start, tree_height(parallel));
+    destroy_arena(parallel_arena);
+
+    // Lookups
+    start = now_ns();
+    for (size_t i = 0; i < queries; i++) {
+        acc += (uintptr_t)search_tree(tree, keys[i]);
+    }
+    report("search_tree", pattern, n, queries, now_ns() - start, tree_height(tree));
+
+    start = now_ns();
+    search_tree_batch(tree, keys, queries, nodes);
+    report("search_tree_batch", pattern, n, queries, now_ns() - start, tree_height(tree));
+
+    bst_frozen_ptr_t frozen = freeze_tree(tree);
+    if (frozen != NULL) {
+        start = now_ns();
+        for (size_t i = 0; i < queries; i++) {
+            acc += (uintptr_t)search_frozen(frozen, keys[i]);
+        }
+        report("search_frozen", pattern, n, queries, now_ns() - start, tree_height(tree));
+
+        start = now_ns();
+        search_frozen_batch(frozen, keys, queries, found);
+        report("search_frozen_batch", pattern, n, queries, now_ns() - start, tree_height(tree));
+
+        // Snapshot round trip: opening is a map plus a header check, queries fault pages in
+        start = now_ns();
+        if (save_snapshot(frozen, SNAPSHOT_PATH) == 0) {
+            report("snapshot_save", pattern, n, n, now_ns() - start, tree_height(tree));
+
+            start = now_ns();
+            bst_snapshot_ptr_t snapshot = open_snapshot(SNAPSHOT_PATH);
+            report("snapshot_open", pattern, n, 1, now_ns() - start, tree_height(tree));
+            if (snapshot != NULL) {
+                start = now_ns();
+                for (size_t i = 0; i < queries; i++) {
+                    acc += (uintptr_t)search_frozen(&snapshot->frozen, keys[i]);
+                }
+                report("snapshot_search", pattern, n, queries, now_ns() - start, tree_height(tree));
+                close_snapshot(snapshot);
+            }
+            remove(SNAPSHOT_PATH);
+        }
+        destroy_frozen(frozen);
+    }
+
+    // Scans
+    start = now_ns();
+    traverse_in_order(tree, count_visitor, &acc);
+    report("traverse_in_order", pattern, n, n, now_ns() - start, tree_height(tree));
+
+    size_t windows = (queries < 10000) ? queries : 10000;
+    size_t visited = 0;
+    start = now_ns();
+    for (size_t i = 0; i < windows; i++) {
+        visited += range_query(tree, keys[i], keys[i] + RANGE_WINDOW, BST_RANGE_INCLUSIVE, 0, count_visitor, &acc);
+    }
+    report("range_query", pattern, n, windows, now_ns() - start, tree_height(tree));
+
+    bst_agg_t agg;
+    start = now_ns();
+    for (size_t i = 0; i < queries; i++) {
+        acc += aggregate_range(tree, keys[i], keys[i] + RANGE_WINDOW, BST_RANGE_INCLUSIVE, &agg);
+    }
+    report("aggregate_range", pattern, n, queries, now_ns() - start, tree_height(tree));
+
+    // Same window aggregates over the columnar copy of the data
+    colstore_ptr_t store = create_colstore(n);
+    if (store != NULL) {
+        for (size_t i = 0; i < n; i++) {
+            colstore_append(store, &scratch[i]);
+        }
+        colstore_agg_t col_agg;
+        start = now_ns();
+        for (size_t i = 0; i < windows; i++) {
+            acc += colstore_aggregate(store, keys[i], keys[i] + RANGE_WINDOW, &col_agg);
+        }
+        report("colstore_aggregate", pattern, n, windows, now_ns() - start, 0);
+        destroy_colstore(store);
+    }
+
+    destroy_arena(arena);
+    sink = acc + visited + (uintptr_t)nodes[0] + (uintptr_t)found[0];
+    free(scratch);
+    free(keys);
+    free(nodes);
+    free(found);
+}
+
+// Same per-sample work as the acquisition loop in main.c, plus the conversion kernels on their own
+static void run_sensor_bench(size_t n) {
+    int rtn_code;
+    uint32_t* io_base = iom361_initialize(0, 0, &rtn_code);
+    if (rtn_code != 0) {
+        fprintf(stderr, "ERROR(run_sensor_bench): Could not initialize I/O module\n");
+        return;
+    }
+
+    uint32_t* temp_raw = (uint32_t*)malloc(n * sizeof(uint32_t));
+    uint32_t* humid_raw = (uint32_t*)malloc(n * sizeof(uint32_t));
+    float* temp = (float*)malloc(n * sizeof(float));
+    float* humid = (float*)malloc(n * sizeof(float));
+    if (temp_raw == NULL || humid_raw == NULL || temp == NULL || humid == NULL) {
+        fprintf(stderr, "ERROR(run_sensor_bench): Could not allocate buffers\n");
+        free(temp_raw);
+        free(humid_raw);
+        free(temp);
+        free(humid);
+        return;
+    }
+
+    double start = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        _iom361_setSensor1_rndm(TEMP_RANGE_LOW, TEMP_RANGE_HI, HUMID_RANGE_LOW, HUMID_RANGE_HI);
+        iom361_sample_t sample;
+        iom361_readSensor1(io_base, &sample, NULL);
+        temp_raw[i] = sample.temp;
+        humid_raw[i] = sample.humid;
+    }
+    iom361_convertTemp(temp_raw, temp, n);
+    iom361_convertHumid(humid_raw, humid, n);
+    report("sensor_read_loop", "random", n, n, now_ns() - start, 0);
+
+    // Register access alone: one readReg per register, one block read, and capture mode
+    uint64_t regs = 0;
+    start = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        regs += iom361_readReg(io_base, TEMP_REG, NULL);
+        regs += iom361_readReg(io_base, HUMID_REG, NULL);
+    }
+    report("read_reg_pair", "random", n, n, now_ns() - start, 0);
+
+    start = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        iom361_sample_t sample;
+        iom361_readSensor1(io_base, &sample, NULL);
+        regs += sample.temp + sample.humid;
+    }
+    report("read_sensor1", "random", n, n, now_ns() - start, 0);
+
+    iom361_sample_t ring_buf[CAPTURE_RING];
+    iom361_ring_t ring = {ring_buf, CAPTURE_RING, 0, 0};
+    start = now_ns();
+    for (size_t done = 0; done < n; done += CAPTURE_RING) {
+        int burst = (n - done < CAPTURE_RING) ? (int)(n - done) : CAPTURE_RING;
+        iom361_captureSensor1(io_base, &ring, burst, NULL);
+        regs += ring_buf[0].temp;
+    }
+    report("capture_sensor1", "random", n, n, now_ns() - start, 0);
+
+    // The per-sample pow() formulas main.c used before the batch kernels
+    float acc = 0;
+    start = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        temp[i] = (temp_raw[i] / powf(2, 20)) * 200.0 - 50;
+        humid[i] = (humid_raw[i] / pow(2, 20)) * 100;
+    }
+    report("convert_pow", "random", n, n, now_ns() - start, 0);
+    acc += temp[n - 1] + humid[n - 1];
+
+    start = now_ns();
+    iom361_convertTemp(temp_raw, temp, n);
+    iom361_convertHumid(humid_raw, humid, n);
+    report("convert_batch", "random", n, n, now_ns() - start, 0);
+    acc += temp[n - 1] + humid[n - 1];
+
+    sink = (uint64_t)acc + regs;
+    free(temp_raw);
+    free(humid_raw);
+    free(temp);
+    free(humid);
+}
+
+static void* fleet_worker(void* arg) {
+    fleet_worker_t* worker = (fleet_worker_t*)arg;
+    uint64_t acc = 0;
+
+    float_rand_seed(worker->seed);
+    for (size_t i = 0; i < worker->n; i++) {
+        _iom361_devSetSensor1_rndm(worker->dev, TEMP_RANGE_LOW, TEMP_RANGE_HI, HUMID_RANGE_LOW, HUMID_RANGE_HI);
+        iom361_sample_t sample;
+        iom361_devReadSensor1(worker->dev, &sample, NULL);
+        acc += sample.temp + sample.humid;
+    }
+    worker->acc = acc;
+    return NULL;
+}
+
+// Update and read loop on FLEET_DEVICES independent boards, each driven by its own thread
+static void run_fleet_bench(size_t n) {
+    fleet_worker_t workers[FLEET_DEVICES];
+    pthread_t threads[FLEET_DEVICES];
+    int created = 0;
+
+    for (; created < FLEET_DEVICES; created++) {
+        workers[created] = (fleet_worker_t){iom361_create(0, 0, NULL), n / FLEET_DEVICES, rng_state + created, 0};
+        if (workers[created].dev == NULL) break;
+    }
+
+    size_t ops = 0;
+    int started = 0;
+    double start = now_ns();
+    for (int d = 0; d < created; d++) {
+        if (pthread_create(&threads[started], NULL, fleet_worker, &workers[d]) != 0) break;
+        started++;
+    }
+    for (int d = 0; d < started; d++) {
+        pthread_join(threads[d], NULL);
+        ops += workers[d].n;
+        sink += workers[d].acc;
+    }
+    double elapsed = now_ns() - start;
+    if (ops > 0) {
+        report("sensor_fleet", "random", n, ops, elapsed, 0);
+    }
+
+    for (int d = 0; d < created; d++) {
+        iom361_destroy(workers[d].dev);
+    }
+}
+
+// Shuffling a copy of the readings, and building a permutation of their indices
+static void run_shuffle_bench(const temp_humid_data_t* data, size_t n) {
+    temp_humid_data_t* copy = (temp_humid_data_t*)malloc(n * sizeof(temp_humid_data_t));
+    if (copy == NULL) {
+        fprintf(stderr, "ERROR(run_shuffle_bench): Could not allocate buffers\n");
+        return;
+    }
+    memcpy(copy, data, n * sizeof(temp_humid_data_t));
+
+    double start = now_ns();
+    shuffle_readings(copy, n);
+    report("shuffle_readings", "sorted", n, n, now_ns() - start, 0);
+    sink = (uint64_t)copy[0].timestamp;
+
+    start = now_ns();
+    size_t* perm = random_permutation(n);
+    report("random_permutation", "sorted", n, n, now_ns() - start, 0);
+    if (perm != NULL) {
+        sink = perm[0];
+    }
+
+    free(perm);
+    free(copy);
+}
+
+static int count_sink(const temp_humid_data_t* batch, size_t n, void* ctx) {
+    uint64_t* acc = (uint64_t*)ctx;
+    for (size_t i = 0; i < n; i++) {
+        *acc += batch[i].temp;
+    }
+    return 0;
+}
+
+// Parsing a CSV and a binary log from a temporary file, alone and into a tree
+static void run_ingest_bench(const temp_humid_data_t* data, size_t n) {
+    static const char* names[][2] = {{"ingest_csv", "ingest_csv_tree"}, {"ingest_binary", "ingest_binary_tree"}};
+    ingest_format_t formats[] = {INGEST_CSV, INGEST_BINARY};
+
+    for (int f = 0; f < 2; f++) {
+        FILE* log = tmpfile();
+        if (log == NULL || ingest_write(log, formats[f], data, n) != 0) {
+            fprintf(stderr, "ERROR(run_ingest_bench): Could not write the log\n");
+            if (log != NULL) fclose(log);
+            return;
+        }
+
+        uint64_t acc = 0;
+        ingest_stats_t stats;
+        rewind(log);
+        double start = now_ns();
+        ingest_stream(log, formats[f], count_sink, &acc, &stats);
+        report(names[f][0], "sorted", n, stats.readings, now_ns() - start, 0);
+
+        bst_arena_ptr_t arena = create_arena(0);
+        bst_node_ptr_t tree = NULL;
+        rewind(log);
+        start = now_ns();
+        ingest_into_tree(log, formats[f], &tree, arena, &stats);
+        report(names[f][1], "sorted", n, stats.readings, now_ns() - start, tree_height(tree));
+
+        sink = acc;
+        destroy_arena(arena);
+        fclose(log);
+    }
+}
+
+// Durable logging with one fdatasync() per WAL_GROUP readings, then recovery into a tree
+static void run_wal_bench(const temp_humid_data_t* data, size_t n) {
+    remove(WAL_PATH);
+    wal_ptr_t wal = wal_open(WAL_PATH, WAL_GROUP);
+    if (wal == NULL) {
+        fprintf(stderr, "ERROR(run_wal_bench): Could not open %s\n", WAL_PATH);
+        return;
+    }
+
+    double start = now_ns();
+    for (size_t done = 0; done < n; done += SPSC_BATCH) {
+        size_t batch = (n - done < SPSC_BATCH) ? n - done : SPSC_BATCH;
+        wal_append(wal, &data[done], batch);
+    }
+    wal_close(wal);
+    report("wal_append", "sorted", n, n, now_ns() - start, 0);
+
+    bst_arena_ptr_t arena = create_arena(0);
+    bst_node_ptr_t tree = NULL;
+    wal_replay_stats_t stats;
+    start = now_ns();
+    if (wal_replay(WAL_PATH, &tree, arena, &stats) == 0) {
+        report("wal_replay", "sorted", n, stats.readings, now_ns() - start, tree_height(tree));
+    }
+    destroy_arena(arena);
+    remove(WAL_PATH);
+}
+
+// Random readings in a range: rand() as float_rndm used it, one draw at a time, and batched
+static void run_rand_bench(size_t n) {
+    double* out = (double*)malloc(n * sizeof(double));
+    if (out == NULL) {
+        fprintf(stderr, "ERROR(run_rand_bench): Could not allocate buffers\n");
+        return;
+    }
+
+    double acc = 0;
+    double start = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        out[i] = TEMP_RANGE_LOW + (TEMP_RANGE_HI - TEMP_RANGE_LOW) * ((double)rand() / RAND_MAX);
+    }
+    report("rand_libc", "random", n, n, now_ns() - start, 0);
+    acc += out[n - 1];
+
+    start = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        out[i] = float_rand_in_range(TEMP_RANGE_LOW, TEMP_RANGE_HI);
+    }
+    report("float_rand_in_range", "random", n, n, now_ns() - start, 0);
+    acc += out[n - 1];
+
+    start = now_ns();
+    float_rand_fill(out, n, TEMP_RANGE_LOW, TEMP_RANGE_HI);
+    report("float_rand_fill", "random", n, n, now_ns() - start, 0);
+    acc += out[n - 1];
+
+    sink = (uint64_t)acc;
+    free(out);
+}
+
+// Date to timestamp conversion as done for generated days and typed queries
+static void run_date_bench(size_t n) {
+    int* month = (int*)malloc(n * sizeof(int));
+    int* day = (int*)malloc(n * sizeof(int));
+    int* year = (int*)malloc(n * sizeof(int));
+    time_t* out = (time_t*)malloc(n * sizeof(time_t));
+    if (month == NULL || day == NULL || year == NULL || out == NULL) {
+        fprintf(stderr, "ERROR(run_date_bench): Could not allocate buffers\n");
+        free(month);
+        free(day);
+        free(year);
+        free(out);
+        return;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        month[i] = 1 + next_rand() % 12;
+        day[i] = 1 + next_rand() % 28;
+        year[i] = 1970 + next_rand() % 100;
+    }
+
+    time_t acc = 0;
+    double start = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        acc += con_to_ut(month[i], day[i], year[i]);
+    }
+    report("con_to_ut", "random", n, n, now_ns() - start, 0);
+
+    start = now_ns();
+    con_to_ut_batch(month, day, year, n, 0, out);
+    report("con_to_ut_batch", "random", n, n, now_ns() - start, 0);
+
+    sink = (uint64_t)(acc + out[n - 1]);
+    free(month);
+    free(day);
+    free(year);
+    free(out);
+}
+
+static void* ring_producer(void* arg) {
+    ring_producer_t* producer = (ring_producer_t*)arg;
+
+    for (size_t i = 0; i < producer->n; ) {
+        size_t batch = (producer->n - i < SPSC_BATCH) ? producer->n - i : SPSC_BATCH;
+        size_t pushed = spsc_push(producer->ring, &producer->data[i], batch);
+        if (pushed == 0) {
+            sched_yield();
+        }
+        i += pushed;
+    }
+    spsc_close(producer->ring);
+    return NULL;
+}
+
+// Acquisition -> ingest handoff through the SPSC ring, one producer and one consumer thread
+static void run_ring_bench(const temp_humid_data_t* data, size_t n) {
+    spsc_ring_ptr_t ring = create_spsc_ring(SPSC_CAPACITY);
+    if (ring == NULL) return;
+
+    ring_producer_t producer = {ring, data, n};
+    temp_humid_data_t batch[SPSC_BATCH];
+    uint64_t acc = 0;
+    pthread_t thread;
+
+    double start = now_ns();
+    if (pthread_create(&thread, NULL, ring_producer, &producer) != 0) {
+        fprintf(stderr, "ERROR(run_ring_bench): Could not start the producer thread\n");
+        destroy_spsc_ring(ring);
+        return;
+    }
+    for (;;) {
+        size_t got = spsc_pop(ring, batch, SPSC_BATCH);
+        for (size_t i = 0; i < got; i++) {
+            acc += batch[i].temp;
+        }
+        if (got == 0) {
+            if (spsc_drained(ring)) break;
+            sched_yield();
+        }
+    }
+    pthread_join(thread, NULL);
+    report("spsc_ring", "sorted", n, n, now_ns() - start, 0);
+
+    sink = acc;
+    destroy_spsc_ring(ring);
+}
+
+// Bursts of DUP_BURST readings per timestamp inserted as chained nodes, as one
+// node per timestamp, and capped per node, then every reading of a timestamp looked up
+static void run_dup_bench(const char* pattern, const temp_humid_data_t* data, size_t n, size_t queries) {
+    static const bst_dup_policy_t policies[] = {BST_DUP_CHAIN, BST_DUP_MULTI, BST_DUP_KEEP_LATEST};
+    static const char* names[] = {"chain", "multi", "keep_latest"};
+
+    temp_humid_data_t* bursts = (temp_humid_data_t*)malloc(n * sizeof(temp_humid_data_t));
+    time_t* keys = (time_t*)malloc(queries * sizeof(time_t));
+    if (bursts == NULL || keys == NULL) {
+        fprintf(stderr, "ERROR(run_dup_bench): Could not allocate %zu readings\n", n);
+        free(bursts);
+        free(keys);
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        bursts[i] = data[i];
+        bursts[i].timestamp = data[i / DUP_BURST].timestamp;
+    }
+    for (size_t i = 0; i < queries; i++) {
+        keys[i] = bursts[next_rand() % n].timestamp;
+    }
+
+    uint64_t acc = 0;
+    for (size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++) {
+        char name[48];
+        bst_arena_ptr_t arena = create_arena(0);
+        bst_node_ptr_t tree = NULL;
+
+        double start = now_ns();
+        for (size_t i = 0; i < n; i++) {
+            insert_node_policy(&tree, bursts[i], arena, policies[p]);
+        }
+        snprintf(name, sizeof(name), "insert_dup_%s", names[p]);
+        report(name, pattern, n, n, now_ns() - start, tree_height(tree));
+
+        temp_humid_data_t found[DUP_BURST];
+        start = now_ns();
+        for (size_t i = 0; i < queries; i++) {
+            acc += search_tree_all(tree, keys[i], found, DUP_BURST);
+        }
+        snprintf(name, sizeof(name), "search_tree_all_%s", names[p]);
+        report(name, pattern, n, queries, now_ns() - start, tree_height(tree));
+        destroy_arena(arena);
+    }
+
+    sink = acc;
+    free(keys);
+    free(bursts);
+}
+
+// Minute-bucketed index ingesting on one shard and on SHARD_WORKERS shards, plus
+// SHARD_WORKERS shards with hour buckets, where a time-ordered stream stays on one
+// worker for an hour's worth of readings.  The last index is then queried across
+// shards with the same windows as the single tree.
+static void run_shard_bench(const char* pattern, const temp_humid_data_t* data, size_t n, size_t queries) {
+    static const struct {
+        int shards;
+        time_t bucket;
+        const char* name;
+    } configs[] = {
+        {1, SHARD_BUCKET_MINUTE, "shard_insert_1"},
+        {SHARD_WORKERS, SHARD_BUCKET_HOUR, "shard_insert_hour"},
+        {SHARD_WORKERS, SHARD_BUCKET_MINUTE, "shard_insert"},
+    };
+    shard_index_ptr_t index = NULL;
+
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        destroy_shard_index(index);
+        index = create_shard_index(configs[c].shards, configs[c].bucket);
+        if (index == NULL) {
+            fprintf(stderr, "ERROR(run_shard_bench): Could not create %d shards\n", configs[c].shards);
+            return;
+        }
+        double start = now_ns();
+        for (size_t done = 0; done < n; done += SPSC_BATCH) {
+            shard_insert(index, &data[done], (n - done < SPSC_BATCH) ? n - done : SPSC_BATCH);
+        }
+        if (shard_flush(index) != 0) {
+            fprintf(stderr, "ERROR(run_shard_bench): %zu readings could not be inserted\n", shard_failed(index));
+            destroy_shard_index(index);
+            return;
+        }
+        report(configs[c].name, pattern, n, n, now_ns() - start, 0);
+    }
+
+    size_t windows = (queries < 10000) ? queries : 10000;
+    uint64_t acc = 0;
+    double start = now_ns();
+    for (size_t i = 0; i < windows; i++) {
+        time_t low = data[next_rand() % n].timestamp;
+        shard_range_query(index, low, low + RANGE_WINDOW, BST_RANGE_INCLUSIVE, 0, count_visitor, &acc);
+    }
+    report("shard_range_query", pattern, n, windows, now_ns() - start, 0);
+
+    bst_agg_t agg;
+    start = now_ns();
+    for (size_t i = 0; i < windows; i++) {
+        time_t low = data[next_rand() % n].timestamp;
+        acc += shard_aggregate(index, low, low + RANGE_WINDOW, BST_RANGE_INCLUSIVE, &agg);
+    }
+    report("shard_aggregate", pattern, n, windows, now_ns() - start, 0);
+
+    sink = acc;
+    destroy_shard_index(index);
+}
+
+static void* rcu_reader(void* arg) {
+    rcu_reader_t* reader = (rcu_reader_t*)arg;
+    int slot = rcu_register_reader(reader->tree);
+    temp_humid_data_t found;
+
+    // Every reader slot is taken: sit this run out rather than search without one
+    if (slot < 0) {
+        fprintf(stderr, "ERROR(rcu_reader): No free reader slot\n");
+        return NULL;
+    }
+
+    for (size_t i = 0; !atomic_load_explicit(reader->stop, memory_order_relaxed); i++) {
+        if (rcu_search(reader->tree, slot, reader->keys[i % reader->queries], &found)) {
+            reader->acc += found.temp;
+        }
+        reader->done++;
+    }
+    rcu_unregister_reader(reader->tree, slot);
+    return NULL;
+}
+
+// Single writer inserting while RCU_READERS threads look up timestamps in the same tree
+static void run_rcu_bench(const char* pattern, const temp_humid_data_t* data, size_t n) {
+    rcu_tree_ptr_t tree = create_rcu_tree(0);
+    time_t* keys = (time_t*)malloc(n * sizeof(time_t));
+    if (tree == NULL || keys == NULL) {
+        destroy_rcu_tree(tree);
+        free(keys);
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = data[next_rand() % n].timestamp;
+    }
+
+    atomic_bool stop;
+    atomic_init(&stop, false);
+    rcu_reader_t readers[RCU_READERS];
+    pthread_t threads[RCU_READERS];
+    int started = 0;
+    for (int r = 0; r < RCU_READERS; r++) {
+        readers[r] = (rcu_reader_t){tree, keys, n, &stop, 0, 0};
+        if (pthread_create(&threads[r], NULL, rcu_reader, &readers[r]) != 0) break;
+        started++;
+    }
+
+    double start = now_ns();
+    for (size_t i = 0; i < n; i++) {
+        rcu_insert(tree, data[i]);
+    }
+    double elapsed = now_ns() - start;
+    atomic_store(&stop, true);
+
+    size_t reads = 0;
+    for (int r = 0; r < started; r++) {
+        pthread_join(threads[r], NULL);
+        reads += readers[r].done;
+        sink += readers[r].acc;
+    }
+    bst_node_ptr_t root = atomic_load(&tree->root);
+    report("rcu_insert", pattern, n, n, elapsed, tree_height(root));
+    report("rcu_search_concurrent", pattern, n, reads, elapsed, tree_height(root));
+
+    destroy_rcu_tree(tree);
+    free(keys);
+}
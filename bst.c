@@ -1,10 +1,126 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+#include <pthread.h>
 #include "bst.h"
 
-bst_node_ptr_t create_new_node(temp_humid_data_t data) {
-    bst_node_ptr_t new_node = (bst_node_ptr_t)malloc(sizeof(bst_node_t));
+// Below this many readings the parallel build just calls the serial one
+#define BST_PARALLEL_MIN 65536
+
+#if defined(__GNUC__)
+#define BST_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define BST_PREFETCH(addr)
+#endif
+
+bst_arena_ptr_t create_arena(size_t slab_nodes) {
+    bst_arena_ptr_t arena = (bst_arena_ptr_t)malloc(sizeof(bst_arena_t));
+    if (arena == NULL) {
+        printf("Error! Failed to allocate memory for function[create_arena].\n");
+        return NULL;
+    }
+    arena->slabs = NULL;
+    arena->current = NULL;
+    arena->slab_nodes = (slab_nodes == 0) ? BST_ARENA_SLAB_NODES : slab_nodes;
+    arena->free_list = NULL;
+    arena->dups = NULL;
+    return arena;
+}
+
+static void free_dups(bst_dups_t* dups) {
+    while (dups != NULL) {
+        bst_dups_t* next = dups->next;
+        free(dups->readings);
+        free(dups);
+        dups = next;
+    }
+}
+
+void destroy_arena(bst_arena_ptr_t arena) {
+    if (arena == NULL) return;
+
+    bst_slab_t* slab = arena->slabs;
+    while (slab != NULL) {
+        bst_slab_t* next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    free_dups(arena->dups);
+    free(arena);
+}
+
+void reset_arena(bst_arena_ptr_t arena) {
+    for (bst_slab_t* slab = arena->slabs; slab != NULL; slab = slab->next) {
+        slab->used = 0;
+    }
+    arena->current = arena->slabs;
+    arena->free_list = NULL;
+    free_dups(arena->dups);
+    arena->dups = NULL;
+}
+
+static bst_node_ptr_t arena_alloc_node(bst_arena_ptr_t arena) {
+    if (arena == NULL) {
+        return (bst_node_ptr_t)malloc(sizeof(bst_node_t));
+    }
+
+    // Recycled nodes first
+    if (arena->free_list != NULL) {
+        bst_node_ptr_t node = arena->free_list;
+        arena->free_list = node->left;
+        return node;
+    }
+
+    // Then the current slab, moving on to slabs emptied by reset_arena() before growing
+    bst_slab_t* slab = arena->current;
+    if (slab != NULL && slab->used == slab->capacity) {
+        slab = slab->next;
+    }
+    if (slab == NULL || slab->used == slab->capacity) {
+        slab = (bst_slab_t*)malloc(sizeof(bst_slab_t) + arena->slab_nodes * sizeof(bst_node_t));
+        if (slab == NULL) return NULL;
+        slab->used = 0;
+        slab->capacity = arena->slab_nodes;
+        slab->next = arena->slabs;
+        arena->slabs = slab;
+    }
+    arena->current = slab;
+    return &slab->nodes[slab->used++];
+}
+
+// Carves n contiguous nodes out of a dedicated slab
+static bst_node_ptr_t arena_alloc_block(bst_arena_ptr_t arena, size_t n) {
+    bst_slab_t* slab = (bst_slab_t*)malloc(sizeof(bst_slab_t) + n * sizeof(bst_node_t));
+    if (slab == NULL) return NULL;
+    slab->used = n;
+    slab->capacity = n;
+
+    // Link in behind the current slab so single node allocations carry on where they were
+    if (arena->current != NULL) {
+        slab->next = arena->current->next;
+        arena->current->next = slab;
+    } else {
+        slab->next = arena->slabs;
+        arena->slabs = slab;
+        arena->current = slab;
+    }
+    return slab->nodes;
+}
+
+static void arena_release_node(bst_arena_ptr_t arena, bst_node_ptr_t node) {
+    if (arena == NULL) {
+        free_dups(node->dups);
+        free(node);
+        return;
+    }
+    node->left = arena->free_list;
+    arena->free_list = node;
+}
+
+static bst_node_ptr_t create_new_node(temp_humid_data_t data, bst_arena_ptr_t arena) {
+    bst_node_ptr_t new_node = arena_alloc_node(arena);
     if (new_node == NULL) {
         printf("Error! Failed to allocate memory for function[new_node].\n");
         return NULL;
@@ -12,69 +128,926 @@ bst_node_ptr_t create_new_node(temp_humid_data_t data) {
     new_node->data = data;
     new_node->left = NULL;
     new_node->right = NULL;
+    new_node->height = 1;
+    new_node->dups = NULL;
+    new_node->agg.count = 1;
+    new_node->agg.temp_sum = data.temp;
+    new_node->agg.humid_sum = data.humid;
+    new_node->agg.temp_min = new_node->agg.temp_max = data.temp;
+    new_node->agg.humid_min = new_node->agg.humid_max = data.humid;
     return new_node;
 }
 
+int tree_height(bst_node_ptr_t tree) {
+    return (tree == NULL) ? 0 : tree->height;
+}
+
+static void agg_clear(bst_agg_t* agg) {
+    agg->count = 0;
+    agg->temp_sum = 0;
+    agg->humid_sum = 0;
+    agg->temp_min = UINT32_MAX;
+    agg->temp_max = 0;
+    agg->humid_min = UINT32_MAX;
+    agg->humid_max = 0;
+}
+
+void bst_agg_merge(bst_agg_t* into, const bst_agg_t* from) {
+    into->count += from->count;
+    into->temp_sum += from->temp_sum;
+    into->humid_sum += from->humid_sum;
+    if (from->temp_min < into->temp_min) into->temp_min = from->temp_min;
+    if (from->temp_max > into->temp_max) into->temp_max = from->temp_max;
+    if (from->humid_min < into->humid_min) into->humid_min = from->humid_min;
+    if (from->humid_max > into->humid_max) into->humid_max = from->humid_max;
+}
+
+static void agg_add_reading(bst_agg_t* agg, const temp_humid_data_t* data) {
+    agg->count++;
+    agg->temp_sum += data->temp;
+    agg->humid_sum += data->humid;
+    if (data->temp < agg->temp_min) agg->temp_min = data->temp;
+    if (data->temp > agg->temp_max) agg->temp_max = data->temp;
+    if (data->humid < agg->humid_min) agg->humid_min = data->humid;
+    if (data->humid > agg->humid_max) agg->humid_max = data->humid;
+}
+
+// Recomputes height and aggregates of node from its children
+static void update_node(bst_node_ptr_t node) {
+    int hl = tree_height(node->left);
+    int hr = tree_height(node->right);
+    node->height = (hl > hr ? hl : hr) + 1;
+
+    agg_clear(&node->agg);
+    agg_add_reading(&node->agg, &node->data);
+    if (node->left != NULL) bst_agg_merge(&node->agg, &node->left->agg);
+    if (node->right != NULL) bst_agg_merge(&node->agg, &node->right->agg);
+    if (node->dups != NULL) bst_agg_merge(&node->agg, &node->dups->agg);
+}
+
+// Adds a node's own reading and the duplicates it holds
+static void agg_add_node(bst_agg_t* agg, bst_node_ptr_t node) {
+    agg_add_reading(agg, &node->data);
+    if (node->dups != NULL) bst_agg_merge(agg, &node->dups->agg);
+}
+
+static bst_node_ptr_t rotate_right(bst_node_ptr_t node) {
+    bst_node_ptr_t pivot = node->left;
+    node->left = pivot->right;
+    pivot->right = node;
+    update_node(node);
+    update_node(pivot);
+    return pivot;
+}
+
+static bst_node_ptr_t rotate_left(bst_node_ptr_t node) {
+    bst_node_ptr_t pivot = node->right;
+    node->right = pivot->left;
+    pivot->left = node;
+    update_node(node);
+    update_node(pivot);
+    return pivot;
+}
+
+// Restores the AVL property at node (children are already balanced), returns the new subtree root
+static bst_node_ptr_t rebalance(bst_node_ptr_t node) {
+    update_node(node);
+    int balance = tree_height(node->left) - tree_height(node->right);
+
+    if (balance > 1) {
+        if (tree_height(node->left->left) < tree_height(node->left->right)) {
+            node->left = rotate_left(node->left);
+        }
+        return rotate_right(node);
+    }
+    if (balance < -1) {
+        if (tree_height(node->right->right) < tree_height(node->right->left)) {
+            node->right = rotate_right(node->right);
+        }
+        return rotate_left(node);
+    }
+    return node;
+}
+
+// Rebalances bottom-up along an insertion path of depth links
+static void rebalance_path(bst_node_ptr_t** path, int depth) {
+    while (depth > 0) {
+        bst_node_ptr_t* link = path[--depth];
+        *link = rebalance(*link);
+    }
+}
+
 void insert_node(bst_node_ptr_t* tree, temp_humid_data_t data) {
-    if (*tree == NULL) {
-        *tree = create_new_node(data);
-        return;
+    insert_node_arena(tree, data, NULL);
+}
+
+void insert_node_arena(bst_node_ptr_t* tree, temp_humid_data_t data, bst_arena_ptr_t arena) {
+    insert_node_policy(tree, data, arena, BST_DUP_CHAIN);
+}
+
+// Empty duplicate vector, chained on the arena when there is one
+static bst_dups_t* create_dups(bst_arena_ptr_t arena) {
+    bst_dups_t* dups = (bst_dups_t*)malloc(sizeof(bst_dups_t));
+    if (dups == NULL) return NULL;
+
+    dups->readings = NULL;
+    dups->count = 0;
+    dups->capacity = 0;
+    agg_clear(&dups->agg);
+    dups->next = NULL;
+    if (arena != NULL) {
+        dups->next = arena->dups;
+        arena->dups = dups;
     }
+    return dups;
+}
 
-    if (data.timestamp <= (*tree)->data.timestamp) {
-        insert_node(&(*tree)->left, data);
-    } else {
-        insert_node(&(*tree)->right, data);
+// Appends a reading to node's duplicate vector, creating or growing it as needed
+static int append_dup(bst_node_ptr_t node, temp_humid_data_t data, bst_arena_ptr_t arena) {
+    bst_dups_t* dups = node->dups;
+
+    if (dups == NULL) {
+        if ((dups = create_dups(arena)) == NULL) {
+            printf("Error! Failed to allocate memory for function[insert_node_policy].\n");
+            return -1;
+        }
+        node->dups = dups;
     }
+
+    if (dups->count == dups->capacity) {
+        uint32_t capacity = (dups->capacity == 0) ? 4 : 2 * dups->capacity;
+        temp_humid_data_t* readings = (temp_humid_data_t*)realloc(dups->readings, capacity * sizeof(temp_humid_data_t));
+        if (readings == NULL) {
+            printf("Error! Failed to allocate memory for function[insert_node_policy].\n");
+            return -1;
+        }
+        dups->readings = readings;
+        dups->capacity = capacity;
+    }
+    dups->readings[dups->count++] = data;
+    agg_add_reading(&dups->agg, &data);
+    return BST_INSERT_APPENDED;
+}
+
+// Applies policy to a reading whose timestamp node already holds
+static int merge_duplicate(bst_node_ptr_t node, temp_humid_data_t data, bst_arena_ptr_t arena,
+                           bst_dup_policy_t policy) {
+    bst_dups_t* dups = node->dups;
+
+    switch (policy) {
+        case BST_DUP_REJECT:
+            return BST_INSERT_REJECTED;
+
+        case BST_DUP_OVERWRITE:
+            node->data = data;
+            if (dups != NULL) {
+                dups->count = 0;
+                agg_clear(&dups->agg);
+            }
+            return BST_INSERT_REPLACED;
+
+        case BST_DUP_KEEP_LATEST:
+            if (dups != NULL && 1 + dups->count >= BST_DUP_LATEST_MAX) {
+                // Full: the oldest reading leaves through the node's own slot
+                node->data = dups->readings[0];
+                memmove(dups->readings, dups->readings + 1, (dups->count - 1) * sizeof(temp_humid_data_t));
+                dups->readings[dups->count - 1] = data;
+                agg_clear(&dups->agg);
+                for (uint32_t i = 0; i < dups->count; i++) {
+                    agg_add_reading(&dups->agg, &dups->readings[i]);
+                }
+                return BST_INSERT_REPLACED;
+            }
+            return append_dup(node, data, arena);
+
+        default:
+            return append_dup(node, data, arena);
+    }
+}
+
+int insert_node_policy(bst_node_ptr_t* tree, temp_humid_data_t data, bst_arena_ptr_t arena,
+                       bst_dup_policy_t policy) {
+    bst_node_ptr_t* path[BST_MAX_HEIGHT];
+    int depth = 0;
+
+    // Walk down, remembering the link we followed at each level.  Chained duplicates
+    // go left; any other policy stops at the first node with the timestamp.
+    bst_node_ptr_t* link = tree;
+    while (*link != NULL) {
+        path[depth++] = link;
+        time_t key = (*link)->data.timestamp;
+        if (data.timestamp == key && policy != BST_DUP_CHAIN) break;
+        link = (data.timestamp <= key) ? &(*link)->left : &(*link)->right;
+    }
+
+    if (*link == NULL) {
+        *link = create_new_node(data, arena);
+        if (*link == NULL) return -1;
+        rebalance_path(path, depth);
+        return BST_INSERT_ADDED;
+    }
+
+    // No node was added, so no heights change and the walk back up only refreshes aggregates
+    int status = merge_duplicate(*link, data, arena, policy);
+    if (status == BST_INSERT_REPLACED || status == BST_INSERT_APPENDED) {
+        rebalance_path(path, depth);
+    }
+    return status;
+}
+
+// Gives a path copy its own duplicate vector.  The original keeps its vector, since
+// readers of the old version can still reach it and retire may free it.  On failure
+// the copy is left without a vector.
+static int copy_dups(bst_node_ptr_t copy, bst_arena_ptr_t arena) {
+    const bst_dups_t* original = copy->dups;
+    if (original == NULL) return 0;
+
+    bst_dups_t* dups = create_dups(arena);
+    copy->dups = NULL;
+    if (dups == NULL) return -1;
+    if (original->count > 0) {
+        dups->readings = (temp_humid_data_t*)malloc(original->count * sizeof(temp_humid_data_t));
+        if (dups->readings == NULL) {
+            if (arena == NULL) free(dups);     // an arena's vectors go with the arena
+            return -1;
+        }
+        memcpy(dups->readings, original->readings, original->count * sizeof(temp_humid_data_t));
+    }
+    dups->count = original->count;
+    dups->capacity = original->count;
+    dups->agg = original->agg;
+    copy->dups = dups;
+    return 0;
+}
+
+// Frees the path copies of a failed copy-on-write insert
+static void release_copies(bst_node_ptr_t** path, int depth, bst_arena_ptr_t arena) {
+    while (depth > 0) {
+        arena_release_node(arena, *path[--depth]);
+    }
+}
+
+bst_node_ptr_t insert_node_cow(bst_node_ptr_t tree, temp_humid_data_t data, bst_arena_ptr_t arena,
+                               bst_retire_fn retire, void* ctx) {
+    bst_node_ptr_t* path[BST_MAX_HEIGHT];
+    bst_node_ptr_t originals[BST_MAX_HEIGHT];
+    int depth = 0;
+    bst_node_ptr_t root = tree;
+
+    // Walk down copying every node on the path; the copies are private until returned
+    bst_node_ptr_t* link = &root;
+    while (*link != NULL) {
+        bst_node_ptr_t copy = arena_alloc_node(arena);
+        if (copy == NULL) {
+            printf("Error! Failed to allocate memory for function[insert_node_cow].\n");
+            release_copies(path, depth, arena);
+            return tree;
+        }
+        *copy = **link;
+        if (copy_dups(copy, arena) != 0) {
+            printf("Error! Failed to allocate memory for function[insert_node_cow].\n");
+            arena_release_node(arena, copy);
+            release_copies(path, depth, arena);
+            return tree;
+        }
+        originals[depth] = *link;
+        *link = copy;
+        path[depth++] = link;
+        if (data.timestamp <= copy->data.timestamp) {
+            link = &copy->left;
+        } else {
+            link = &copy->right;
+        }
+    }
+
+    *link = create_new_node(data, arena);
+    if (*link == NULL) {
+        release_copies(path, depth, arena);
+        return tree;
+    }
+
+    // Rotations after an insert only involve nodes on the insertion path, so they
+    // only ever relink the copies and never touch a node readers can still see
+    rebalance_path(path, depth);
+
+    if (retire != NULL) {
+        for (int i = 0; i < depth; i++) {
+            retire(originals[i], ctx);
+        }
+    }
+    return root;
 }
 
 bst_node_ptr_t create_tree(temp_humid_data_t* arr, int size) {
+    return create_tree_arena(arr, size, NULL);
+}
+
+bst_node_ptr_t create_tree_arena(temp_humid_data_t* arr, int size, bst_arena_ptr_t arena) {
     if (size <= 0) return NULL;
 
+    if (is_sorted_by_timestamp(arr, size)) {
+        return create_tree_sorted(arr, size, arena);
+    }
+
     bst_node_ptr_t root = NULL;
     for (int i = 0; i < size; i++) {
-        insert_node(&root, arr[i]);
+        insert_node_arena(&root, arr[i], arena);
     }
     return root;
 }
 
-void traverse_in_order(bst_node_ptr_t tree) {
-    if (tree == NULL) return;
+int is_sorted_by_timestamp(const temp_humid_data_t* arr, int size) {
+    for (int i = 1; i < size; i++) {
+        if (arr[i].timestamp < arr[i - 1].timestamp) return 0;
+    }
+    return 1;
+}
 
-    traverse_in_order(tree->left);
-    printf("Timestamp: %ld, Temp: %u, Humid: %u\n", tree->data.timestamp, tree->data.temp, tree->data.humid);
-    traverse_in_order(tree->right);
+// Radix key: timestamp with the sign bit flipped so negative times order first
+static uint64_t radix_key(const temp_humid_data_t* item) {
+    return (uint64_t)item->timestamp ^ ((uint64_t)1 << 63);
 }
 
-bst_node_ptr_t search_tree(bst_node_ptr_t tree, time_t timestamp) {
-    //printf("DEBUG: timestamp = %ld\n", timestamp);
-    if (tree == NULL) {
-        printf("No result found!\n");
+int sort_by_timestamp(temp_humid_data_t* arr, int size) {
+    if (size <= 1) return 0;
+
+    size_t count[8][256] = {{0}};
+    for (int i = 0; i < size; i++) {
+        uint64_t key = radix_key(&arr[i]);
+        for (int b = 0; b < 8; b++) {
+            count[b][(key >> (8 * b)) & 0xFF]++;
+        }
+    }
+
+    temp_humid_data_t* scratch = (temp_humid_data_t*)malloc((size_t)size * sizeof(temp_humid_data_t));
+    if (scratch == NULL) {
+        printf("Error! Failed to allocate memory for function[sort_by_timestamp].\n");
+        return -1;
+    }
+
+    temp_humid_data_t* src = arr;
+    temp_humid_data_t* dst = scratch;
+    for (int b = 0; b < 8; b++) {
+        // A byte every key shares doesn't reorder anything
+        if (count[b][(radix_key(&arr[0]) >> (8 * b)) & 0xFF] == (size_t)size) continue;
+
+        size_t offset = 0;
+        for (int d = 0; d < 256; d++) {
+            size_t c = count[b][d];
+            count[b][d] = offset;
+            offset += c;
+        }
+        for (int i = 0; i < size; i++) {
+            dst[count[b][(radix_key(&src[i]) >> (8 * b)) & 0xFF]++] = src[i];
+        }
+        temp_humid_data_t* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != arr) {
+        for (int i = 0; i < size; i++) {
+            arr[i] = src[i];
+        }
+    }
+    free(scratch);
+    return 0;
+}
+
+// Links nodes[lo..hi] (in-order sequence) into a balanced subtree, returns its root
+static bst_node_ptr_t link_balanced(bst_node_ptr_t nodes, int lo, int hi) {
+    if (lo > hi) return NULL;
+
+    int mid = lo + (hi - lo) / 2;
+    bst_node_ptr_t node = &nodes[mid];
+    node->dups = NULL;
+    node->left = link_balanced(nodes, lo, mid - 1);
+    node->right = link_balanced(nodes, mid + 1, hi);
+    update_node(node);
+    return node;
+}
+
+// Same as link_balanced() for individually allocated nodes, NULL if any allocation fails
+static bst_node_ptr_t build_balanced(temp_humid_data_t* arr, int lo, int hi, bst_arena_ptr_t arena) {
+    if (lo > hi) return NULL;
+
+    int mid = lo + (hi - lo) / 2;
+    bst_node_ptr_t node = create_new_node(arr[mid], arena);
+    if (node == NULL) return NULL;
+
+    // A NULL child for a non-empty range means an allocation failed below; free what
+    // was built here so the caller never sees a tree with readings missing
+    node->left = build_balanced(arr, lo, mid - 1, arena);
+    if (node->left == NULL && lo <= mid - 1) {
+        arena_release_node(arena, node);
+        return NULL;
+    }
+    node->right = build_balanced(arr, mid + 1, hi, arena);
+    if (node->right == NULL && mid + 1 <= hi) {
+        destroy_tree(node->left, arena);
+        arena_release_node(arena, node);
         return NULL;
     }
+    update_node(node);
+    return node;
+}
 
-    if (timestamp == tree->data.timestamp) {
-        printf("Timestamp: %ld, Temp: %u, Humid: %u\n", tree->data.timestamp, tree->data.temp, tree->data.humid);
-        return tree;
-    } else if (timestamp < tree->data.timestamp) {
-        return search_tree(tree->left, timestamp);
-    } else {
-        return search_tree(tree->right, timestamp);
+bst_node_ptr_t create_tree_sorted(temp_humid_data_t* arr, int size, bst_arena_ptr_t arena) {
+    if (size <= 0) return NULL;
+
+    if (!is_sorted_by_timestamp(arr, size) && sort_by_timestamp(arr, size) != 0) {
+        return NULL;
+    }
+
+    if (arena == NULL) {
+        return build_balanced(arr, 0, size - 1, NULL);
     }
+
+    bst_node_ptr_t nodes = arena_alloc_block(arena, (size_t)size);
+    if (nodes == NULL) {
+        printf("Error! Failed to allocate memory for function[create_tree_sorted].\n");
+        return NULL;
+    }
+    for (int i = 0; i < size; i++) {
+        nodes[i].data = arr[i];
+    }
+    return link_balanced(nodes, 0, size - 1);
 }
 
-time_t con_to_ut(int month, int day, int year) {
+// One thread's slice of a parallel radix sort pass
+typedef struct radix_part {
+    const temp_humid_data_t* src;
+    temp_humid_data_t* dst;
+    int lo;
+    int hi;
+    int shift;
+    uint64_t diff;          // bits where some key in the slice differs from the first key
+    size_t count[256];      // digit counts, then this slice's scatter offsets
+} radix_part_t;
+
+typedef void* (*parallel_fn)(void* arg);
+
+// Runs fn on every part, one thread each, with part 0 on the calling thread.  A part
+// whose thread cannot be started runs inline, so the work always gets done.
+static void run_parts(parallel_fn fn, radix_part_t* parts, int nparts) {
+    pthread_t threads[BST_MAX_THREADS];
+    int started[BST_MAX_THREADS] = {0};
+
+    for (int t = 1; t < nparts; t++) {
+        started[t] = (pthread_create(&threads[t], NULL, fn, &parts[t]) == 0);
+        if (!started[t]) fn(&parts[t]);
+    }
+    fn(&parts[0]);
+    for (int t = 1; t < nparts; t++) {
+        if (started[t]) pthread_join(threads[t], NULL);
+    }
+}
+
+static void* radix_diff_part(void* arg) {
+    radix_part_t* part = (radix_part_t*)arg;
+    uint64_t first = radix_key(&part->src[0]);
+    uint64_t diff = 0;
+
+    for (int i = part->lo; i < part->hi; i++) {
+        diff |= radix_key(&part->src[i]) ^ first;
+    }
+    part->diff = diff;
+    return NULL;
+}
+
+static void* radix_count_part(void* arg) {
+    radix_part_t* part = (radix_part_t*)arg;
+
+    for (int d = 0; d < 256; d++) {
+        part->count[d] = 0;
+    }
+    for (int i = part->lo; i < part->hi; i++) {
+        part->count[(radix_key(&part->src[i]) >> part->shift) & 0xFF]++;
+    }
+    return NULL;
+}
+
+static void* radix_scatter_part(void* arg) {
+    radix_part_t* part = (radix_part_t*)arg;
+
+    for (int i = part->lo; i < part->hi; i++) {
+        part->dst[part->count[(radix_key(&part->src[i]) >> part->shift) & 0xFF]++] = part->src[i];
+    }
+    return NULL;
+}
+
+static void* copy_part(void* arg) {
+    radix_part_t* part = (radix_part_t*)arg;
+
+    for (int i = part->lo; i < part->hi; i++) {
+        part->dst[i] = part->src[i];
+    }
+    return NULL;
+}
+
+// Thread count to use for a request of nthreads, 0 meaning one per online CPU
+static int parallel_threads(int nthreads) {
+    if (nthreads <= 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (online > 0) ? (int)online : 1;
+    }
+    return (nthreads > BST_MAX_THREADS) ? BST_MAX_THREADS : nthreads;
+}
+
+int sort_by_timestamp_parallel(temp_humid_data_t* arr, int size, int nthreads) {
+    nthreads = parallel_threads(nthreads);
+    if (nthreads == 1 || size < BST_PARALLEL_MIN) {
+        return sort_by_timestamp(arr, size);
+    }
+
+    radix_part_t* parts = (radix_part_t*)malloc((size_t)nthreads * sizeof(radix_part_t));
+    temp_humid_data_t* scratch = (temp_humid_data_t*)malloc((size_t)size * sizeof(temp_humid_data_t));
+    if (parts == NULL || scratch == NULL) {
+        printf("Error! Failed to allocate memory for function[sort_by_timestamp_parallel].\n");
+        free(parts);
+        free(scratch);
+        return -1;
+    }
+
+    // Each thread owns one contiguous slice of whichever buffer is the source
+    for (int t = 0; t < nthreads; t++) {
+        parts[t].lo = (int)((long long)size * t / nthreads);
+        parts[t].hi = (int)((long long)size * (t + 1) / nthreads);
+        parts[t].src = arr;
+    }
+    run_parts(radix_diff_part, parts, nthreads);
+    uint64_t diff = 0;
+    for (int t = 0; t < nthreads; t++) {
+        diff |= parts[t].diff;
+    }
+
+    temp_humid_data_t* src = arr;
+    temp_humid_data_t* dst = scratch;
+    for (int b = 0; b < 8; b++) {
+        // A byte every key shares doesn't reorder anything
+        if (((diff >> (8 * b)) & 0xFF) == 0) continue;
+
+        for (int t = 0; t < nthreads; t++) {
+            parts[t].src = src;
+            parts[t].dst = dst;
+            parts[t].shift = 8 * b;
+        }
+        run_parts(radix_count_part, parts, nthreads);
+
+        // Digit d of slice t lands after every smaller digit and after digit d of
+        // the slices before it, which keeps the sort stable
+        size_t offset = 0;
+        for (int d = 0; d < 256; d++) {
+            for (int t = 0; t < nthreads; t++) {
+                size_t c = parts[t].count[d];
+                parts[t].count[d] = offset;
+                offset += c;
+            }
+        }
+        run_parts(radix_scatter_part, parts, nthreads);
+
+        temp_humid_data_t* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != arr) {
+        for (int t = 0; t < nthreads; t++) {
+            parts[t].src = src;
+            parts[t].dst = arr;
+        }
+        run_parts(copy_part, parts, nthreads);
+    }
+    free(scratch);
+    free(parts);
+    return 0;
+}
+
+// A subtree of the parallel build.  Above depth 0 the left half is forked to a new
+// thread while the current one builds the right half.
+typedef struct build_task {
+    temp_humid_data_t* arr;
+    bst_node_ptr_t nodes;   // contiguous in-order nodes, or NULL to malloc() each node
+    int lo;
+    int hi;
+    int depth;
+    bst_node_ptr_t root;
+    int failed;             // a node allocation failed; nothing of the subtree is left allocated
+} build_task_t;
+
+static void* build_task(void* arg) {
+    build_task_t* task = (build_task_t*)arg;
+    int lo = task->lo;
+    int hi = task->hi;
+
+    if (task->depth == 0 || lo > hi) {
+        if (task->nodes == NULL) {
+            task->root = build_balanced(task->arr, lo, hi, NULL);
+            task->failed = (task->root == NULL && lo <= hi);
+            return NULL;
+        }
+        for (int i = lo; i <= hi; i++) {
+            task->nodes[i].data = task->arr[i];
+        }
+        task->root = link_balanced(task->nodes, lo, hi);
+        return NULL;
+    }
+
+    // Same midpoint split as link_balanced(), so the shape matches the serial build
+    int mid = lo + (hi - lo) / 2;
+    bst_node_ptr_t node;
+    if (task->nodes != NULL) {
+        node = &task->nodes[mid];
+        node->data = task->arr[mid];
+        node->dups = NULL;
+    } else if ((node = create_new_node(task->arr[mid], NULL)) == NULL) {
+        task->root = NULL;
+        task->failed = 1;
+        return NULL;
+    }
+
+    build_task_t left = {task->arr, task->nodes, lo, mid - 1, task->depth - 1, NULL, 0};
+    build_task_t right = {task->arr, task->nodes, mid + 1, hi, task->depth - 1, NULL, 0};
+    pthread_t thread;
+    int forked = (pthread_create(&thread, NULL, build_task, &left) == 0);
+    if (!forked) build_task(&left);
+    build_task(&right);
+    if (forked) pthread_join(thread, NULL);
+
+    // Only malloc()ed nodes can fail; drop the half that did build along with this node
+    if (left.failed || right.failed) {
+        destroy_tree(left.root, NULL);
+        destroy_tree(right.root, NULL);
+        arena_release_node(NULL, node);
+        task->root = NULL;
+        task->failed = 1;
+        return NULL;
+    }
+    node->left = left.root;
+    node->right = right.root;
+    update_node(node);
+    task->root = node;
+    return NULL;
+}
+
+bst_node_ptr_t create_tree_parallel(temp_humid_data_t* arr, int size, bst_arena_ptr_t arena, int nthreads) {
+    if (size <= 0) return NULL;
+
+    nthreads = parallel_threads(nthreads);
+    if (nthreads == 1 || size < BST_PARALLEL_MIN) {
+        return create_tree_sorted(arr, size, arena);
+    }
+
+    if (!is_sorted_by_timestamp(arr, size) && sort_by_timestamp_parallel(arr, size, nthreads) != 0) {
+        return NULL;
+    }
+
+    bst_node_ptr_t nodes = NULL;
+    if (arena != NULL && (nodes = arena_alloc_block(arena, (size_t)size)) == NULL) {
+        printf("Error! Failed to allocate memory for function[create_tree_parallel].\n");
+        return NULL;
+    }
+
+    // Fork down until there is a subtree for every thread
+    int depth = 0;
+    while ((1 << depth) < nthreads) {
+        depth++;
+    }
+    build_task_t task = {arr, nodes, 0, size - 1, depth, NULL, 0};
+    build_task(&task);
+    return task.failed ? NULL : task.root;
+}
+
+void destroy_node(bst_node_ptr_t node, bst_arena_ptr_t arena) {
+    arena_release_node(arena, node);
+}
+
+void destroy_tree(bst_node_ptr_t tree, bst_arena_ptr_t arena) {
+    // Rotate left children up until the root has none, then release it and move right.
+    // Each rotation moves one node onto the right spine, so the whole walk is O(n).
+    while (tree != NULL) {
+        bst_node_ptr_t left = tree->left;
+        if (left != NULL) {
+            tree->left = left->right;
+            left->right = tree;
+            tree = left;
+        } else {
+            bst_node_ptr_t right = tree->right;
+            arena_release_node(arena, tree);
+            tree = right;
+        }
+    }
+}
+
+// Visits node's own reading, then the duplicates it holds, counting each.  Returns
+// non-zero once the visitor asks to stop or limit readings have been visited.
+static int visit_node(bst_node_ptr_t node, bst_visitor_t visit, void* ctx, size_t* count, size_t limit) {
+    ++*count;
+    if (visit(&node->data, ctx) != 0 || *count == limit) return 1;
+    if (node->dups != NULL) {
+        for (uint32_t i = 0; i < node->dups->count; i++) {
+            ++*count;
+            if (visit(&node->dups->readings[i], ctx) != 0 || *count == limit) return 1;
+        }
+    }
+    return 0;
+}
+
+size_t traverse_in_order(bst_node_ptr_t tree, bst_visitor_t visit, void* ctx) {
+    bst_node_ptr_t stack[BST_MAX_HEIGHT];
+    int top = 0;
+    size_t count = 0;
+
+    while (tree != NULL || top > 0) {
+        // Push the left spine, then visit the smallest pending node and move right
+        while (tree != NULL) {
+            stack[top++] = tree;
+            tree = tree->left;
+        }
+        tree = stack[--top];
+        if (visit_node(tree, visit, ctx, &count, 0) != 0) break;
+        tree = tree->right;
+    }
+    return count;
+}
+
+size_t range_query(bst_node_ptr_t tree, time_t low, time_t high, int flags, size_t limit,
+                   bst_visitor_t visit, void* ctx) {
+    if (low > high) return 0;
+
+    // Timestamps are whole seconds, so exclusive bounds are just tighter inclusive ones
+    if (flags & BST_RANGE_EXCLUDE_LOW) {
+        if (low == high) return 0;
+        low++;
+    }
+    if (flags & BST_RANGE_EXCLUDE_HIGH) {
+        if (low == high) return 0;
+        high--;
+    }
+
+    bst_node_ptr_t stack[BST_MAX_HEIGHT];
+    int top = 0;
+    size_t count = 0;
+
+    while (tree != NULL || top > 0) {
+        // Descend towards low; a node below the window takes its left subtree with it
+        while (tree != NULL) {
+            if (tree->data.timestamp < low) {
+                tree = tree->right;
+            } else {
+                stack[top++] = tree;
+                tree = tree->left;
+            }
+        }
+        if (top == 0) break;
+
+        tree = stack[--top];
+        if (tree->data.timestamp > high) break;
+        if (visit_node(tree, visit, ctx, &count, limit) != 0) break;
+        tree = tree->right;
+    }
+    return count;
+}
+
+uint64_t aggregate_range(bst_node_ptr_t tree, time_t low, time_t high, int flags, bst_agg_t* out) {
+    agg_clear(out);
+    if (low > high) return 0;
+
+    if (flags & BST_RANGE_EXCLUDE_LOW) {
+        if (low == high) return 0;
+        low++;
+    }
+    if (flags & BST_RANGE_EXCLUDE_HIGH) {
+        if (low == high) return 0;
+        high--;
+    }
+
+    // Find the topmost node inside the window, where the paths to low and high split
+    while (tree != NULL && (tree->data.timestamp < low || tree->data.timestamp > high)) {
+        tree = (tree->data.timestamp < low) ? tree->right : tree->left;
+    }
+    if (tree == NULL) return 0;
+    agg_add_node(out, tree);
+
+    // Path to low: everything in the split's left subtree is <= high, so each node
+    // at or above low brings its whole right subtree along
+    for (bst_node_ptr_t node = tree->left; node != NULL; ) {
+        if (node->data.timestamp >= low) {
+            agg_add_node(out, node);
+            if (node->right != NULL) bst_agg_merge(out, &node->right->agg);
+            node = node->left;
+        } else {
+            node = node->right;
+        }
+    }
+
+    // Path to high, mirrored
+    for (bst_node_ptr_t node = tree->right; node != NULL; ) {
+        if (node->data.timestamp <= high) {
+            agg_add_node(out, node);
+            if (node->left != NULL) bst_agg_merge(out, &node->left->agg);
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return out->count;
+}
 
-    // struct tm from time.h
-    struct tm tm = {0};
-    tm.tm_year = year - 1900;
-    tm.tm_mon = month - 1;
-    tm.tm_mday = day;
+// Context for range_query_buffer()
+typedef struct {
+    temp_humid_data_t* out;
+    size_t used;
+} range_buffer_t;
 
-    // fn from time.h
-    time_t result = mktime(&tm);
+static int copy_to_buffer(const temp_humid_data_t* data, void* ctx) {
+    range_buffer_t* buf = (range_buffer_t*)ctx;
+    buf->out[buf->used++] = *data;
+    return 0;
+}
+
+size_t range_query_buffer(bst_node_ptr_t tree, time_t low, time_t high, int flags,
+                          temp_humid_data_t* out, size_t max) {
+    if (max == 0) return 0;
+
+    range_buffer_t buf = {out, 0};
+    return range_query(tree, low, high, flags, max, copy_to_buffer, &buf);
+}
+
+bst_node_ptr_t search_tree(bst_node_ptr_t tree, time_t timestamp) {
+    while (tree != NULL && timestamp != tree->data.timestamp) {
+        tree = (timestamp < tree->data.timestamp) ? tree->left : tree->right;
+    }
+    return tree;
+}
 
-    return result;
+size_t search_tree_all(bst_node_ptr_t tree, time_t timestamp, temp_humid_data_t* out, size_t max) {
+    return range_query_buffer(tree, timestamp, timestamp, BST_RANGE_INCLUSIVE, out, max);
 }
 
+void search_tree_batch(bst_node_ptr_t tree, const time_t* timestamps, size_t n, bst_node_ptr_t* out) {
+    for (size_t base = 0; base < n; base += BST_BATCH_LANES) {
+        size_t lanes = (n - base < BST_BATCH_LANES) ? n - base : BST_BATCH_LANES;
+        const time_t* keys = &timestamps[base];
+        bst_node_ptr_t* cur = &out[base];
 
+        for (size_t i = 0; i < lanes; i++) {
+            cur[i] = tree;
+        }
+
+        // Step every unfinished lane down one level per round
+        int active = 1;
+        while (active) {
+            active = 0;
+            for (size_t i = 0; i < lanes; i++) {
+                bst_node_ptr_t node = cur[i];
+                if (node == NULL || node->data.timestamp == keys[i]) continue;
+
+                node = (keys[i] < node->data.timestamp) ? node->left : node->right;
+                if (node != NULL) {
+                    BST_PREFETCH(node);
+                    active = 1;
+                }
+                cur[i] = node;
+            }
+        }
+    }
+}
+
+time_t con_to_ut(int month, int day, int year) {
+    return con_to_ut_offset(month, day, year, 0);
+}
+
+time_t con_to_ut_offset(int month, int day, int year, long utc_offset) {
+    // Bring the month into 1..12, carrying whole years like mktime() does
+    int64_t y = year + (month - 1) / 12;
+    int m = (month - 1) % 12;
+    if (m < 0) {
+        m += 12;
+        y--;
+    }
+
+    return (time_t)(days_from_civil(y, m + 1, day) * 86400 - utc_offset);
+}
+
+// Whole 400-year eras added to the years in con_to_ut_batch() so its arithmetic stays unsigned
+#define BATCH_SHIFT_ERAS 25
+
+void con_to_ut_batch(const int* month, const int* day, const int* year, size_t n,
+                     long utc_offset, time_t* out) {
+    // Days from the shifted epoch to 1970-01-01, taken off once at the end
+    const int64_t epoch = 719468 + (int64_t)BATCH_SHIFT_ERAS * 146097;
+
+    for (size_t i = 0; i < n; i++) {
+        // Months since March of the shifted year 0: one unsigned divide both normalizes
+        // out of range months and starts the year in March, leaving leap days last
+        uint32_t months = (uint32_t)year[i] * 12u + (uint32_t)month[i] - 3u + BATCH_SHIFT_ERAS * 400u * 12u;
+        uint32_t y = months / 12u;
+        uint32_t mp = months - y * 12u;                             // [0, 11], 0 is March
+        uint32_t era = y / 400u;
+        uint32_t yoe = y - era * 400u;                              // [0, 399]
+        uint32_t doe = yoe * 365u + yoe / 4u - yoe / 100u + (153u * mp + 2u) / 5u;
+        int64_t days = (int64_t)era * 146097 + doe + day[i] - 1 - epoch;
+        out[i] = (time_t)(days * 86400 - utc_offset);
+    }
+}
@@ -14,7 +14,9 @@
 #ifndef _BST_H
 #define _BST_H
 
+#include <stddef.h>
 #include <stdint.h>
+#include <time.h>
 
 // Structure for storing timestamp data and simulated temperature/humidity readings.
 typedef struct temp_humid_data {
@@ -23,13 +25,122 @@ typedef struct temp_humid_data {
     uint32_t humid;
 } temp_humid_data_t, *temp_humid_data_ptr_t;
 
-// Node structure to be used by BST
+// Upper bound on the height of an AVL tree we can build (would need > 10^13 nodes).
+// Sizes the explicit stacks used by the iterative insert and traversal.
+#define BST_MAX_HEIGHT 64
+
+// Aggregates over a set of readings.  Mean temp/humid is temp_sum/count and humid_sum/count.
+typedef struct bst_agg {
+    uint64_t count;
+    uint64_t temp_sum;
+    uint64_t humid_sum;
+    uint32_t temp_min;
+    uint32_t temp_max;
+    uint32_t humid_min;
+    uint32_t humid_max;
+} bst_agg_t, *bst_agg_ptr_t;
+
+// Further readings that share a node's timestamp, kept by insert_node_policy().
+// Vectors of arena nodes are chained on the arena and freed with it.
+typedef struct bst_dups {
+    struct bst_dups *next;
+    temp_humid_data_t *readings;    // oldest first, after the node's own reading
+    uint32_t count;
+    uint32_t capacity;
+    bst_agg_t agg;                  // covers readings[0..count)
+} bst_dups_t;
+
+// Node structure to be used by BST.  The tree is kept AVL balanced, height is the
+// height of the subtree rooted at this node (a leaf has height 1) and agg covers
+// every reading in that subtree, duplicates included.
 typedef struct bst_node {
     temp_humid_data_t data;
     struct bst_node *left;
     struct bst_node *right;
+    int height;
+    bst_agg_t agg;
+    bst_dups_t *dups;               // NULL unless the node holds several readings
 } bst_node_t, *bst_node_ptr_t;
 
+// What insert_node_policy() does with a reading whose timestamp is already in the tree
+typedef enum {
+    BST_DUP_CHAIN,          // add another node, as insert_node() does
+    BST_DUP_REJECT,         // keep the reading already there
+    BST_DUP_OVERWRITE,      // replace the readings in the first node holding the timestamp
+    BST_DUP_KEEP_LATEST,    // keep the newest BST_DUP_LATEST_MAX readings in the node
+    BST_DUP_MULTI           // keep every reading in the node
+} bst_dup_policy_t;
+
+// Readings a node keeps under BST_DUP_KEEP_LATEST
+#define BST_DUP_LATEST_MAX 4
+
+// insert_node_policy() results, -1 means allocation failed
+#define BST_INSERT_ADDED        0   // new node
+#define BST_INSERT_REJECTED     1   // tree unchanged
+#define BST_INSERT_REPLACED     2   // an existing reading was dropped for the new one
+#define BST_INSERT_APPENDED     3   // stored alongside the readings already there
+
+// Bound flags for range queries, both bounds are inclusive by default
+#define BST_RANGE_INCLUSIVE     0x0
+#define BST_RANGE_EXCLUDE_LOW   0x1
+#define BST_RANGE_EXCLUDE_HIGH  0x2
+
+// Visitor called once per reading.  Return non-zero to stop the walk early.
+typedef int (*bst_visitor_t)(const temp_humid_data_t* data, void* ctx);
+
+// Called by insert_node_cow() for every node the new version no longer uses
+typedef void (*bst_retire_fn)(bst_node_ptr_t node, void* ctx);
+
+// Number of lookups search_tree_batch() walks down the tree in lockstep
+#define BST_BATCH_LANES 8
+
+// Upper bound on threads used by the parallel build and sort
+#define BST_MAX_THREADS 64
+
+// Default number of nodes carved out of each arena slab
+#define BST_ARENA_SLAB_NODES 4096
+
+// Slab of nodes owned by an arena.  Slabs are chained newest first.
+typedef struct bst_slab {
+    struct bst_slab *next;
+    size_t used;
+    size_t capacity;
+    bst_node_t nodes[];
+} bst_slab_t;
+
+// Node arena: hands out nodes from slabs and recycles released nodes through a free list
+typedef struct bst_arena {
+    bst_slab_t *slabs;
+    bst_slab_t *current;        // slab nodes are being carved from
+    size_t slab_nodes;
+    bst_node_ptr_t free_list;   // released nodes, chained through their left pointer
+    bst_dups_t *dups;           // duplicate vectors of nodes carved from this arena
+} bst_arena_t, *bst_arena_ptr_t;
+
+/**
+ * @brief Creates an empty node arena.
+ *
+ * @param slab_nodes Number of nodes per slab, 0 selects BST_ARENA_SLAB_NODES.
+ * @return bst_arena_ptr_t Pointer to the arena, or NULL if allocation fails.
+ */
+bst_arena_ptr_t create_arena(size_t slab_nodes);
+
+/**
+ * @brief Releases every slab of the arena and the arena itself.  All trees built in the
+ * arena are freed in bulk and must not be used afterwards.
+ *
+ * @param arena Pointer to the arena (NULL is ignored).
+ */
+void destroy_arena(bst_arena_ptr_t arena);
+
+/**
+ * @brief Empties the arena so its slabs can be reused.  All trees built in the arena
+ * become invalid, but no memory is returned to the system.
+ *
+ * @param arena Pointer to the arena.
+ */
+void reset_arena(bst_arena_ptr_t arena);
+
 /**
  * @brief Creates a binary search tree (BST) from an array of temperature and humidity data.
  *
@@ -39,6 +150,84 @@ typedef struct bst_node {
  */
 bst_node_ptr_t create_tree(temp_humid_data_t* arr, int size);
 
+/**
+ * @brief Same as create_tree(), but nodes are allocated from the given arena.
+ *
+ * Input that is already sorted by timestamp is bulk built in O(n) as in create_tree_sorted().
+ *
+ * @param arr Pointer to an array of temp_humid_data_t containing the data.
+ * @param size The size of the array.
+ * @param arena Arena to allocate nodes from, NULL uses malloc().
+ * @return bst_node_ptr_t Pointer to the root node of the created BST.
+ */
+bst_node_ptr_t create_tree_arena(temp_humid_data_t* arr, int size, bst_arena_ptr_t arena);
+
+/**
+ * @brief Builds a perfectly balanced BST from an array in O(n).
+ *
+ * If the array is not already sorted by timestamp it is radix sorted in place first.
+ * With an arena, all nodes are carved from one contiguous block in in-order sequence;
+ * with a NULL arena each node is malloc()ed.
+ *
+ * @param arr Pointer to an array of temp_humid_data_t, reordered if not sorted.
+ * @param size The size of the array.
+ * @param arena Arena to allocate nodes from, NULL uses malloc().
+ * @return bst_node_ptr_t Pointer to the root node of the created BST, or NULL if memory
+ * could not be allocated (nothing is left allocated then).
+ */
+bst_node_ptr_t create_tree_sorted(temp_humid_data_t* arr, int size, bst_arena_ptr_t arena);
+
+/**
+ * @brief Same as create_tree_sorted(), spread over several threads.
+ *
+ * The radix sort runs each pass over per-thread slices, and the top levels of the
+ * midpoint split are forked onto their own threads until there is one subtree per
+ * thread.  The resulting tree is identical to create_tree_sorted()'s.  Arrays below
+ * a few tens of thousands of readings are built serially.
+ *
+ * @param arr Pointer to an array of temp_humid_data_t, reordered if not sorted.
+ * @param size The size of the array.
+ * @param arena Arena to allocate nodes from, NULL uses malloc().
+ * @param nthreads Threads to use, 0 for one per online CPU (at most BST_MAX_THREADS).
+ * @return bst_node_ptr_t Pointer to the root node of the created BST, or NULL if memory
+ * could not be allocated (nothing is left allocated then).
+ */
+bst_node_ptr_t create_tree_parallel(temp_humid_data_t* arr, int size, bst_arena_ptr_t arena, int nthreads);
+
+/**
+ * @brief Checks whether an array is in non-decreasing timestamp order.
+ *
+ * @param arr Pointer to an array of temp_humid_data_t.
+ * @param size The size of the array.
+ * @return int 1 if sorted, 0 otherwise.
+ */
+int is_sorted_by_timestamp(const temp_humid_data_t* arr, int size);
+
+/**
+ * @brief Sorts an array by timestamp with a stable LSD radix sort.
+ *
+ * Byte positions where every timestamp agrees are skipped, so data spanning a few
+ * months costs only three or four passes.
+ *
+ * @param arr Pointer to an array of temp_humid_data_t.
+ * @param size The size of the array.
+ * @return int 0 on success, -1 if the scratch buffer could not be allocated.
+ */
+int sort_by_timestamp(temp_humid_data_t* arr, int size);
+
+/**
+ * @brief Same as sort_by_timestamp(), with each radix pass split across threads.
+ *
+ * Threads count digits in their own slice, then scatter to offsets that keep the
+ * slices in order, so the result matches sort_by_timestamp() exactly.
+ *
+ * @param arr Pointer to an array of temp_humid_data_t.
+ * @param size The size of the array.
+ * @param nthreads Threads to use, 0 for one per online CPU (at most BST_MAX_THREADS).
+ * @return int 0 on success, -1 if the scratch buffer could not be allocated.
+ */
+int sort_by_timestamp_parallel(temp_humid_data_t* arr, int size, int nthreads);
+
 /**
  * @brief Creates a single BST node from an array of temperature and humidity data.
  *
@@ -50,13 +239,84 @@ bst_node_ptr_t create_node(temp_humid_data_t* arr);
 /**
  * @brief Inserts a new node with the given data into the BST.
  *
+ * The tree is rebalanced (AVL) on the way back up, so lookups stay O(log n)
+ * regardless of insertion order.  Equal timestamps are placed in the left subtree.
+ *
  * @param tree Pointer to the pointer of the root node of the BST.
  * @param data The temp_humid_data_t data to be inserted into the BST.
  */
 void insert_node(bst_node_ptr_t* tree, temp_humid_data_t data);
 
 /**
- * @brief Searches the BST for a node with a specific timestamp.
+ * @brief Same as insert_node(), but the new node is allocated from the given arena.
+ *
+ * @param tree Pointer to the pointer of the root node of the BST.
+ * @param data The temp_humid_data_t data to be inserted into the BST.
+ * @param arena Arena to allocate the node from, NULL uses malloc().
+ */
+void insert_node_arena(bst_node_ptr_t* tree, temp_humid_data_t data, bst_arena_ptr_t arena);
+
+/**
+ * @brief Inserts a reading, resolving an already present timestamp with policy.
+ *
+ * Every policy but BST_DUP_CHAIN stops at the first node with the timestamp, so
+ * bursts of same-second samples never add depth.  Readings kept in the node are
+ * covered by its aggregates and visited by traversals and range queries.
+ *
+ * @param tree Pointer to the root node pointer of the BST.
+ * @param data The temp_humid_data_t structure containing the data to be inserted.
+ * @param arena Arena to allocate the node and duplicates from, NULL uses malloc().
+ * @param policy What to do when the timestamp is already in the tree.
+ * @return int A BST_INSERT_* result, or -1 if memory could not be allocated.
+ */
+int insert_node_policy(bst_node_ptr_t* tree, temp_humid_data_t data, bst_arena_ptr_t arena,
+                       bst_dup_policy_t policy);
+
+/**
+ * @brief Inserts into a new version of the BST without modifying the existing one.
+ *
+ * Every node on the insertion path is copied and rebalanced as a copy, unchanged
+ * subtrees are shared with the old version.  The old tree stays valid and unmodified,
+ * so readers still walking it are unaffected.  The replaced nodes are handed to
+ * retire; they must not be freed until the new root is published and no reader can
+ * still reach them.
+ *
+ * A copied node that holds duplicate readings gets its own copy of the vector, so
+ * the replaced node keeps its vector and retire may free it with destroy_node().
+ * The new reading itself is always chained as a node of its own (BST_DUP_CHAIN).
+ *
+ * @param tree Pointer to the root node of the current version.
+ * @param data The temp_humid_data_t data to be inserted into the BST.
+ * @param arena Arena to allocate the new nodes from, NULL uses malloc().
+ * @param retire Called for each replaced node, may be NULL.
+ * @param ctx Caller context passed through to retire.
+ * @return bst_node_ptr_t Root of the new version, or tree itself if allocation failed.
+ */
+bst_node_ptr_t insert_node_cow(bst_node_ptr_t tree, temp_humid_data_t data, bst_arena_ptr_t arena,
+                               bst_retire_fn retire, void* ctx);
+
+/**
+ * @brief Frees a single node without touching its children.
+ *
+ * @param node Pointer to the node.
+ * @param arena Arena the node was allocated from, or NULL if it was allocated with malloc().
+ */
+void destroy_node(bst_node_ptr_t node, bst_arena_ptr_t arena);
+
+/**
+ * @brief Frees every node of the BST.
+ *
+ * Nodes are returned to the arena's free list for reuse, or passed to free() when
+ * arena is NULL.  Runs in O(n) time without recursion or an auxiliary stack.
+ *
+ * @param tree Pointer to the root node of the BST.
+ * @param arena Arena the tree was built in, or NULL if it was built with malloc().
+ */
+void destroy_tree(bst_node_ptr_t tree, bst_arena_ptr_t arena);
+
+/**
+ * @brief Searches the BST for a node with a specific timestamp.  Prints nothing,
+ * see bst_print.h for console output.
  *
  * @param tree Pointer to the root node of the BST.
  * @param timestamp The timestamp to search for.
@@ -64,15 +324,129 @@ void insert_node(bst_node_ptr_t* tree, temp_humid_data_t data);
  */
 bst_node_ptr_t search_tree(bst_node_ptr_t tree, time_t timestamp);
 
+/**
+ * @brief Copies out every reading with the timestamp, whether kept in one node or
+ * chained over several, oldest of each node first.
+ *
+ * @param tree Pointer to the root node of the BST.
+ * @param timestamp The timestamp to search for.
+ * @param out Buffer receiving the readings.
+ * @param max Capacity of out.
+ * @return size_t Number of readings copied, at most max.
+ */
+size_t search_tree_all(bst_node_ptr_t tree, time_t timestamp, temp_humid_data_t* out, size_t max);
+
+/**
+ * @brief Looks up many timestamps at once.
+ *
+ * Walks BST_BATCH_LANES searches down the tree in lockstep and prefetches each
+ * lane's next node, so the cache misses of independent lookups overlap instead
+ * of being paid one after another.
+ *
+ * @param tree Pointer to the root node of the BST.
+ * @param timestamps Array of timestamps to search for.
+ * @param n Number of timestamps.
+ * @param out Receives, for each timestamp, the matching node or NULL if not found.
+ */
+void search_tree_batch(bst_node_ptr_t tree, const time_t* timestamps, size_t n, bst_node_ptr_t* out);
+
+/**
+ * @brief Visits, in timestamp order, every reading with low <= timestamp <= high.
+ *
+ * Only subtrees that can hold timestamps inside the window are walked, so the cost is
+ * O(log n + k) for k matches.
+ *
+ * @param tree Pointer to the root node of the BST.
+ * @param low Lower bound of the window.
+ * @param high Upper bound of the window.
+ * @param flags BST_RANGE_EXCLUDE_LOW and/or BST_RANGE_EXCLUDE_HIGH to make a bound exclusive.
+ * @param limit Maximum number of readings to visit, 0 for no limit.
+ * @param visit Visitor called for each reading.
+ * @param ctx Caller context passed through to the visitor.
+ * @return size_t Number of readings visited.
+ */
+size_t range_query(bst_node_ptr_t tree, time_t low, time_t high, int flags, size_t limit,
+                   bst_visitor_t visit, void* ctx);
+
+/**
+ * @brief Copies, in timestamp order, the readings inside a window into a caller buffer.
+ *
+ * @param tree Pointer to the root node of the BST.
+ * @param low Lower bound of the window.
+ * @param high Upper bound of the window.
+ * @param flags BST_RANGE_EXCLUDE_LOW and/or BST_RANGE_EXCLUDE_HIGH to make a bound exclusive.
+ * @param out Buffer receiving the readings.
+ * @param max Capacity of the buffer, at most this many readings are copied.
+ * @return size_t Number of readings copied.
+ */
+size_t range_query_buffer(bst_node_ptr_t tree, time_t low, time_t high, int flags,
+                          temp_humid_data_t* out, size_t max);
+
+/**
+ * @brief Computes count, sum, min and max of temp and humid over a time window.
+ *
+ * Uses the per-subtree aggregates, so the cost is O(log n) no matter how many
+ * readings fall inside the window.
+ *
+ * @param tree Pointer to the root node of the BST.
+ * @param low Lower bound of the window.
+ * @param high Upper bound of the window.
+ * @param flags BST_RANGE_EXCLUDE_LOW and/or BST_RANGE_EXCLUDE_HIGH to make a bound exclusive.
+ * @param out Receives the aggregates.  count is 0 (and min > max) for an empty window.
+ * @return uint64_t Number of readings inside the window.
+ */
+uint64_t aggregate_range(bst_node_ptr_t tree, time_t low, time_t high, int flags, bst_agg_t* out);
+
+/**
+ * @brief Folds the aggregates in from into into, as if their readings were combined.
+ *
+ * An empty aggregate (count 0, min > max) leaves into unchanged.
+ *
+ * @param into Aggregates updated in place.
+ * @param from Aggregates to add, e.g. from aggregate_range() over another tree.
+ */
+void bst_agg_merge(bst_agg_t* into, const bst_agg_t* from);
+
 /**
  * @brief Performs an in-order traversal of the BST, visiting each node in ascending order of timestamp.
  *
+ * Iterative, using an explicit stack bounded by BST_MAX_HEIGHT.
+ *
  * @param tree Pointer to the root node of the BST.
+ * @param visit Visitor called for each reading, a non-zero return stops the traversal.
+ * @param ctx Caller context passed through to the visitor.
+ * @return size_t Number of readings visited.
  */
-void traverse_in_order(bst_node_ptr_t tree);
+size_t traverse_in_order(bst_node_ptr_t tree, bst_visitor_t visit, void* ctx);
 
 /**
- * @brief Converts a date (month, day, year) into a Unix timestamp.
+ * @brief Counts days from 01/01/1970 to a proleptic Gregorian date.
+ *
+ * Pure integer arithmetic (Howard Hinnant's days_from_civil), so calls with constant
+ * arguments fold at compile time.  Days past the end of the month roll over into the
+ * next one.
+ *
+ * @param year The year.
+ * @param month The month, 1 to 12.
+ * @param day The day of the month.
+ * @return int64_t Days since the Unix epoch, negative before it.
+ */
+static inline int64_t days_from_civil(int64_t year, int month, int day) {
+    year -= (month <= 2);
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yoe = year - era * 400;                                         // [0, 399]
+    int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;   // [0, 365]
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;                    // [0, 146096]
+    return era * 146097 + doe - 719468;
+}
+
+/**
+ * @brief Converts a date (month, day, year) into a Unix timestamp for midnight UTC.
+ *
+ * Does not consult the TZ database, out of range months and days roll over the
+ * same way mktime() would.  Unlike the mktime() version this replaced, the result
+ * is midnight UTC rather than midnight local time; use con_to_ut_offset() for a
+ * local midnight.
  *
  * @param month The month.
  * @param day The day of the month.
@@ -81,4 +455,43 @@ void traverse_in_order(bst_node_ptr_t tree);
  */
 time_t con_to_ut(int month, int day, int year);
 
+/**
+ * @brief Converts a date into a Unix timestamp for local midnight at a fixed UTC offset.
+ *
+ * @param month The month.
+ * @param day The day of the month.
+ * @param year The year.
+ * @param utc_offset Offset of local time east of UTC in seconds (-25200 for PDT).
+ * @return time_t The Unix timestamp corresponding to the given date.
+ */
+time_t con_to_ut_offset(int month, int day, int year, long utc_offset);
+
+/**
+ * @brief Converts arrays of dates into Unix timestamps, as con_to_ut_offset() does for one.
+ *
+ * Uses 32-bit unsigned month and day-of-era arithmetic with no branches and no
+ * signed division, so the compiler can vectorize the loop; only the final day count
+ * is widened to 64 bits.  Years from -10000 to about 300 million are supported.
+ *
+ * Like con_to_ut(), the result is midnight UTC shifted by utc_offset, not midnight
+ * local time as the mktime() based con_to_ut() used to return.
+ *
+ * @param month Array of months.
+ * @param day Array of days of the month.
+ * @param year Array of years.
+ * @param n Number of dates.
+ * @param utc_offset Offset of local time east of UTC in seconds, 0 for UTC.
+ * @param out Receives the n timestamps.
+ */
+void con_to_ut_batch(const int* month, const int* day, const int* year, size_t n,
+                     long utc_offset, time_t* out);
+
+/**
+ * @brief Returns the height of the BST (0 for an empty tree, 1 for a single node).
+ *
+ * @param tree Pointer to the root node of the BST.
+ * @return int Height of the tree.
+ */
+int tree_height(bst_node_ptr_t tree);
+
 #endif
@@ -0,0 +1,180 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bst_frozen.h"
+
+// Keys per cache line.  Prefetching keys[k * FROZEN_BLOCK] pulls in the 8 descendants
+// of node k three levels down, so memory latency overlaps with the comparisons above them.
+#define FROZEN_BLOCK (64 / sizeof(time_t))
+
+// Number of lookups search_frozen_batch() runs in lockstep
+#define FROZEN_BATCH_LANES 16
+
+#if defined(__GNUC__)
+#define FROZEN_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define FROZEN_PREFETCH(addr)
+#endif
+
+// Readings in the tree, counting the duplicates nodes hold
+static size_t count_readings(bst_node_ptr_t tree) {
+    bst_node_ptr_t stack[BST_MAX_HEIGHT];
+    int top = 0;
+    size_t count = 0;
+
+    while (tree != NULL || top > 0) {
+        while (tree != NULL) {
+            stack[top++] = tree;
+            tree = tree->left;
+        }
+        tree = stack[--top];
+        count += 1 + ((tree->dups != NULL) ? tree->dups->count : 0);
+        tree = tree->right;
+    }
+    return count;
+}
+
+// First Eytzinger slot in in-order sequence: the leftmost node
+static size_t eytzinger_first(size_t n) {
+    size_t k = 1;
+    while (2 * k <= n) {
+        k = 2 * k;
+    }
+    return k;
+}
+
+// In-order successor of slot k in an implicit tree of n slots, 0 past the end
+static size_t eytzinger_next(size_t k, size_t n) {
+    if (2 * k + 1 <= n) {
+        k = 2 * k + 1;
+        while (2 * k <= n) {
+            k = 2 * k;
+        }
+        return k;
+    }
+    // Climb while we are a right child, then once more to the parent we are left of
+    while (k & 1) {
+        k >>= 1;
+    }
+    return k >> 1;
+}
+
+bst_frozen_ptr_t freeze_tree(bst_node_ptr_t tree) {
+    bst_frozen_ptr_t frozen = (bst_frozen_ptr_t)malloc(sizeof(bst_frozen_t));
+    if (frozen == NULL) {
+        printf("Error! Failed to allocate memory for function[freeze_tree].\n");
+        return NULL;
+    }
+    frozen->size = count_readings(tree);
+    frozen->keys = NULL;
+    frozen->data = NULL;
+
+    void* keys = NULL;
+    if (posix_memalign(&keys, 64, (frozen->size + 1) * sizeof(time_t)) != 0
+        || (frozen->data = (temp_humid_data_t*)malloc((frozen->size + 1) * sizeof(temp_humid_data_t))) == NULL) {
+        printf("Error! Failed to allocate memory for function[freeze_tree].\n");
+        free(keys);
+        free(frozen);
+        return NULL;
+    }
+    frozen->keys = (time_t*)keys;
+
+    // Walk the tree and the implicit array in-order side by side
+    bst_node_ptr_t stack[BST_MAX_HEIGHT];
+    int top = 0;
+    size_t k = eytzinger_first(frozen->size);
+
+    while (tree != NULL || top > 0) {
+        while (tree != NULL) {
+            stack[top++] = tree;
+            tree = tree->left;
+        }
+        tree = stack[--top];
+        frozen->keys[k] = tree->data.timestamp;
+        frozen->data[k] = tree->data;
+        k = eytzinger_next(k, frozen->size);
+
+        // Readings kept in the node take the following slots under the same key
+        for (uint32_t i = 0; tree->dups != NULL && i < tree->dups->count; i++) {
+            frozen->keys[k] = tree->data.timestamp;
+            frozen->data[k] = tree->dups->readings[i];
+            k = eytzinger_next(k, frozen->size);
+        }
+        tree = tree->right;
+    }
+    return frozen;
+}
+
+// Turns the slot a descent fell out of into the lower bound it found, NULL unless it matches
+static temp_humid_data_ptr_t frozen_match(const bst_frozen_t* frozen, size_t k, time_t timestamp) {
+    // Undo the trailing right turns plus the final left turn
+#if defined(__GNUC__)
+    k >>= __builtin_ffsll((long long)~k);
+#else
+    while (k & 1) {
+        k >>= 1;
+    }
+    k >>= 1;
+#endif
+
+    if (k == 0 || frozen->keys[k] != timestamp) return NULL;
+    return &frozen->data[k];
+}
+
+temp_humid_data_ptr_t search_frozen(const bst_frozen_t* frozen, time_t timestamp) {
+    const time_t* keys = frozen->keys;
+    size_t n = frozen->size;
+    size_t k = 1;
+
+    // Branchless descent to the first key >= timestamp
+    while (k <= n) {
+        FROZEN_PREFETCH(keys + k * FROZEN_BLOCK);
+        k = 2 * k + (keys[k] < timestamp);
+    }
+    return frozen_match(frozen, k, timestamp);
+}
+
+void search_frozen_batch(const bst_frozen_t* frozen, const time_t* timestamps, size_t n,
+                         temp_humid_data_ptr_t* out) {
+    const time_t* keys = frozen->keys;
+    size_t size = frozen->size;
+    size_t k[FROZEN_BATCH_LANES];
+
+    for (size_t base = 0; base < n; base += FROZEN_BATCH_LANES) {
+        size_t lanes = (n - base < FROZEN_BATCH_LANES) ? n - base : FROZEN_BATCH_LANES;
+        const time_t* query = &timestamps[base];
+
+        // Run for the full depth of the implicit tree; a lane that falls out on the
+        // shorter last level just stops moving
+        for (size_t i = 0; i < lanes; i++) {
+            k[i] = 1;
+        }
+        for (size_t level = 1; level <= size; level *= 2) {
+            for (size_t i = 0; i < lanes; i++) {
+                FROZEN_PREFETCH(keys + k[i] * FROZEN_BLOCK);
+                k[i] = (k[i] <= size) ? 2 * k[i] + (keys[k[i]] < query[i]) : k[i];
+            }
+        }
+        for (size_t i = 0; i < lanes; i++) {
+            out[base + i] = frozen_match(frozen, k[i], query[i]);
+        }
+    }
+}
+
+size_t traverse_frozen(const bst_frozen_t* frozen, bst_visitor_t visit, void* ctx) {
+    size_t visited = 0;
+
+    if (frozen->size == 0) return 0;
+    for (size_t k = eytzinger_first(frozen->size); k != 0; k = eytzinger_next(k, frozen->size)) {
+        visited++;
+        if (visit(&frozen->data[k], ctx) != 0) break;
+    }
+    return visited;
+}
+
+void destroy_frozen(bst_frozen_ptr_t frozen) {
+    if (frozen == NULL) return;
+
+    free(frozen->keys);
+    free(frozen->data);
+    free(frozen);
+}
@@ -0,0 +1,77 @@
+/**
+* bst_frozen.h - Header file for the read-only (frozen) timestamp index
+ *
+ * @file:               bst_frozen.h
+ * @author:            	Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Once a tree is fully loaded it can be frozen into an implicit Eytzinger (BFS order)
+ * array of timestamps with the readings in a parallel array.  Lookups then walk a
+ * single contiguous array with a branchless loop and prefetch the next levels, instead
+ * of chasing child pointers between scattered nodes.
+ *
+ */
+
+#ifndef _BST_FROZEN_H
+#define _BST_FROZEN_H
+
+#include "bst.h"
+
+// Frozen index.  keys[] and data[] are 1-based (slot 0 is unused), node k has children 2k and 2k+1.
+typedef struct bst_frozen {
+    time_t *keys;
+    temp_humid_data_t *data;
+    size_t size;
+} bst_frozen_t, *bst_frozen_ptr_t;
+
+/**
+ * @brief Copies a BST into a frozen Eytzinger index.  The tree is left untouched.
+ * Readings a node holds under a duplicate policy get a slot each.
+ *
+ * @param tree Pointer to the root node of the BST.
+ * @return bst_frozen_ptr_t Pointer to the frozen index, or NULL if allocation fails.
+ */
+bst_frozen_ptr_t freeze_tree(bst_node_ptr_t tree);
+
+/**
+ * @brief Searches a frozen index for a reading with a specific timestamp.
+ *
+ * @param frozen Pointer to the frozen index.
+ * @param timestamp The timestamp to search for.
+ * @return temp_humid_data_ptr_t Pointer to the matching reading, or NULL if not found.
+ */
+temp_humid_data_ptr_t search_frozen(const bst_frozen_t* frozen, time_t timestamp);
+
+/**
+ * @brief Looks up many timestamps in a frozen index at once.
+ *
+ * The branchless descents of a group of lookups run in lockstep, so their
+ * prefetches and cache misses overlap.
+ *
+ * @param frozen Pointer to the frozen index.
+ * @param timestamps Array of timestamps to search for.
+ * @param n Number of timestamps.
+ * @param out Receives, for each timestamp, the matching reading or NULL if not found.
+ */
+void search_frozen_batch(const bst_frozen_t* frozen, const time_t* timestamps, size_t n,
+                         temp_humid_data_ptr_t* out);
+
+/**
+ * @brief Calls visit on every reading of a frozen index in ascending order of timestamp.
+ *
+ * @param frozen Pointer to the frozen index.
+ * @param visit Callback for each reading.  A nonzero return stops the traversal.
+ * @param ctx Passed through to visit.
+ * @return size_t Number of readings visited.
+ */
+size_t traverse_frozen(const bst_frozen_t* frozen, bst_visitor_t visit, void* ctx);
+
+/**
+ * @brief Frees a frozen index.
+ *
+ * @param frozen Pointer to the frozen index (NULL is ignored).
+ */
+void destroy_frozen(bst_frozen_ptr_t frozen);
+
+#endif
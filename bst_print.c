@@ -0,0 +1,29 @@
+#include <stdio.h>
+#include "bst_print.h"
+
+int print_reading(const temp_humid_data_t* data, void* ctx) {
+    FILE* out = (ctx != NULL) ? (FILE*)ctx : stdout;
+    fprintf(out, "Timestamp: %ld, Temp: %u, Humid: %u\n", (long)data->timestamp, data->temp, data->humid);
+    return 0;
+}
+
+void print_tree_in_order(bst_node_ptr_t tree) {
+    traverse_in_order(tree, print_reading, stdout);
+}
+
+void print_search_result(bst_node_ptr_t node) {
+    print_reading_result((node != NULL) ? &node->data : NULL);
+    if (node == NULL || node->dups == NULL) return;
+
+    for (uint32_t i = 0; i < node->dups->count; i++) {
+        print_reading(&node->dups->readings[i], stdout);
+    }
+}
+
+void print_reading_result(const temp_humid_data_t* data) {
+    if (data == NULL) {
+        printf("No result found!\n");
+        return;
+    }
+    print_reading(data, stdout);
+}
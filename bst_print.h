@@ -0,0 +1,50 @@
+/**
+* bst_print.h - Header file for console output of the ECE 361 hw5 binary search tree
+ *
+ * @file:               bst_print.h
+ * @author:            	Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Optional formatting layer on top of bst.h.  The tree itself never prints, these
+ * helpers turn readings and lookup results into the console output used by the demo.
+ *
+ */
+
+#ifndef _BST_PRINT_H
+#define _BST_PRINT_H
+
+#include <stdio.h>
+#include "bst.h"
+
+/**
+ * @brief Visitor that prints one reading as "Timestamp: ..., Temp: ..., Humid: ...".
+ *
+ * @param data Pointer to the reading.
+ * @param ctx FILE* to print to, or NULL for stdout.
+ * @return int Always 0 so traversals continue.
+ */
+int print_reading(const temp_humid_data_t* data, void* ctx);
+
+/**
+ * @brief Prints every reading of the BST in ascending order of timestamp.
+ *
+ * @param tree Pointer to the root node of the BST.
+ */
+void print_tree_in_order(bst_node_ptr_t tree);
+
+/**
+ * @brief Prints the readings held by the node a lookup found, or "No result found!" for NULL.
+ *
+ * @param node Node returned by search_tree(), may be NULL.
+ */
+void print_search_result(bst_node_ptr_t node);
+
+/**
+ * @brief Same as print_search_result() for lookups that return a reading, such as search_frozen().
+ *
+ * @param data Reading found by the lookup, may be NULL.
+ */
+void print_reading_result(const temp_humid_data_t* data);
+
+#endif
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "bst_rcu.h"
+
+#define READER_ACTIVE(epoch)    (((epoch) << 1) | 1)
+
+rcu_tree_ptr_t create_rcu_tree(size_t slab_nodes) {
+    rcu_tree_ptr_t tree = (rcu_tree_ptr_t)aligned_alloc(64, (sizeof(rcu_tree_t) + 63) / 64 * 64);
+    if (tree == NULL) {
+        printf("Error! Failed to allocate memory for function[create_rcu_tree].\n");
+        return NULL;
+    }
+    tree->arena = create_arena(slab_nodes);
+    if (tree->arena == NULL) {
+        free(tree);
+        return NULL;
+    }
+
+    atomic_init(&tree->root, NULL);
+    atomic_init(&tree->epoch, 0);
+    for (int i = 0; i < RCU_MAX_READERS; i++) {
+        atomic_init(&tree->readers[i].state, 0);
+        atomic_init(&tree->readers[i].in_use, false);
+    }
+    for (int i = 0; i < 3; i++) {
+        tree->limbo[i].nodes = NULL;
+        tree->limbo[i].count = 0;
+        tree->limbo[i].capacity = 0;
+    }
+    return tree;
+}
+
+void destroy_rcu_tree(rcu_tree_ptr_t tree) {
+    if (tree == NULL) return;
+
+    // Every node, live or retired, lives in the arena
+    for (int i = 0; i < 3; i++) {
+        free(tree->limbo[i].nodes);
+    }
+    destroy_arena(tree->arena);
+    free(tree);
+}
+
+// Recycles the nodes in one limbo list
+static void reclaim(rcu_tree_ptr_t tree, rcu_limbo_t* limbo) {
+    for (size_t i = 0; i < limbo->count; i++) {
+        destroy_node(limbo->nodes[i], tree->arena);
+    }
+    limbo->count = 0;
+}
+
+// Moves to the next epoch if every active reader has caught up with the current one.
+// Nodes retired two epochs back can no longer be reached by anybody and are recycled.
+static bool try_advance(rcu_tree_ptr_t tree) {
+    uint_fast64_t epoch = atomic_load(&tree->epoch);
+
+    for (int i = 0; i < RCU_MAX_READERS; i++) {
+        uint_fast64_t state = atomic_load(&tree->readers[i].state);
+        if ((state & 1) && state != READER_ACTIVE(epoch)) return false;
+    }
+
+    reclaim(tree, &tree->limbo[(epoch + 1) % 3]);
+    atomic_store(&tree->epoch, epoch + 1);
+    return true;
+}
+
+// insert_node_cow() retire callback: park the node in the current epoch's limbo list
+static void retire_node(bst_node_ptr_t node, void* ctx) {
+    rcu_tree_ptr_t tree = (rcu_tree_ptr_t)ctx;
+    rcu_limbo_t* limbo = &tree->limbo[atomic_load_explicit(&tree->epoch, memory_order_relaxed) % 3];
+
+    if (limbo->count == limbo->capacity) {
+        size_t capacity = (limbo->capacity == 0) ? RCU_RECLAIM_BATCH : limbo->capacity * 2;
+        bst_node_ptr_t* nodes = (bst_node_ptr_t*)realloc(limbo->nodes, capacity * sizeof(bst_node_ptr_t));
+        if (nodes == NULL) {
+            // Leaking the node into the arena is safe, recycling it early is not
+            printf("Error! Failed to allocate memory for function[retire_node].\n");
+            return;
+        }
+        limbo->nodes = nodes;
+        limbo->capacity = capacity;
+    }
+    limbo->nodes[limbo->count++] = node;
+}
+
+int rcu_insert(rcu_tree_ptr_t tree, temp_humid_data_t data) {
+    bst_node_ptr_t old_root = atomic_load_explicit(&tree->root, memory_order_relaxed);
+    bst_node_ptr_t new_root = insert_node_cow(old_root, data, tree->arena, retire_node, tree);
+    if (new_root == old_root) return -1;
+
+    // Release publishes the copied path together with the root
+    atomic_store_explicit(&tree->root, new_root, memory_order_release);
+
+    if (tree->limbo[atomic_load_explicit(&tree->epoch, memory_order_relaxed) % 3].count >= RCU_RECLAIM_BATCH) {
+        try_advance(tree);
+    }
+    return 0;
+}
+
+void rcu_synchronize(rcu_tree_ptr_t tree) {
+    // Three advances recycle everything retired so far, whichever epoch it went into
+    for (int advanced = 0; advanced < 3; ) {
+        if (try_advance(tree)) {
+            advanced++;
+        } else {
+            sched_yield();
+        }
+    }
+}
+
+int rcu_register_reader(rcu_tree_ptr_t tree) {
+    for (int i = 0; i < RCU_MAX_READERS; i++) {
+        bool expected = false;
+        if (atomic_compare_exchange_strong(&tree->readers[i].in_use, &expected, true)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Slots outside the table, such as a failed rcu_register_reader(), are ignored
+static bool valid_slot(int slot) {
+    return slot >= 0 && slot < RCU_MAX_READERS;
+}
+
+void rcu_unregister_reader(rcu_tree_ptr_t tree, int slot) {
+    if (!valid_slot(slot)) return;
+    atomic_store(&tree->readers[slot].state, 0);
+    atomic_store(&tree->readers[slot].in_use, false);
+}
+
+bst_node_ptr_t rcu_read_lock(rcu_tree_ptr_t tree, int slot) {
+    if (!valid_slot(slot)) return NULL;
+
+    // Announce the epoch before loading the root (both seq_cst, so the store can't
+    // sink below the load): the writer then can't recycle anything this snapshot reaches
+    atomic_store(&tree->readers[slot].state, READER_ACTIVE(atomic_load(&tree->epoch)));
+    return atomic_load(&tree->root);
+}
+
+void rcu_read_unlock(rcu_tree_ptr_t tree, int slot) {
+    if (!valid_slot(slot)) return;
+    atomic_store_explicit(&tree->readers[slot].state, 0, memory_order_release);
+}
+
+bool rcu_search(rcu_tree_ptr_t tree, int slot, time_t timestamp, temp_humid_data_t* out) {
+    bst_node_ptr_t node = search_tree(rcu_read_lock(tree, slot), timestamp);
+    if (node != NULL) {
+        *out = node->data;
+    }
+    rcu_read_unlock(tree, slot);
+    return node != NULL;
+}
+
+size_t rcu_range_query(rcu_tree_ptr_t tree, int slot, time_t low, time_t high, int flags, size_t limit,
+                       bst_visitor_t visit, void* ctx) {
+    size_t count = range_query(rcu_read_lock(tree, slot), low, high, flags, limit, visit, ctx);
+    rcu_read_unlock(tree, slot);
+    return count;
+}
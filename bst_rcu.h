@@ -0,0 +1,152 @@
+/**
+* bst_rcu.h - Header file for the concurrent (single writer, many readers) timestamp index
+ *
+ * @file:               bst_rcu.h
+ * @author:            	Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Wraps the BST so queries can run on many threads while one writer keeps inserting.
+ * The writer never modifies a published node: each insert copies its path with
+ * insert_node_cow() and publishes the new root atomically.  Replaced nodes are
+ * reclaimed with epoch-based reclamation, a node is only recycled after every reader
+ * that could have seen it has left its read-side section.  Readers never lock, never
+ * write shared state other than their own slot, and never wait on the writer.
+ *
+ */
+
+#ifndef _BST_RCU_H
+#define _BST_RCU_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include "bst.h"
+
+#define RCU_MAX_READERS     64      // reader slots, one per registered reader thread
+#define RCU_RECLAIM_BATCH   1024    // retired nodes collected before the writer tries to advance the epoch
+
+// Per-reader state, padded to its own cache line.  0 when idle, (epoch << 1) | 1 inside a read section.
+typedef struct rcu_reader_slot {
+    _Alignas(64) atomic_uint_fast64_t state;
+    atomic_bool in_use;
+} rcu_reader_slot_t;
+
+// Nodes retired during one epoch, owned by the writer
+typedef struct rcu_limbo {
+    bst_node_ptr_t *nodes;
+    size_t count;
+    size_t capacity;
+} rcu_limbo_t;
+
+// Concurrent tree.  root and epoch are shared, arena and limbo lists belong to the writer.
+typedef struct rcu_tree {
+    _Atomic(bst_node_ptr_t) root;
+    atomic_uint_fast64_t epoch;
+    rcu_reader_slot_t readers[RCU_MAX_READERS];
+
+    bst_arena_ptr_t arena;
+    rcu_limbo_t limbo[3];           // indexed by epoch % 3
+} rcu_tree_t, *rcu_tree_ptr_t;
+
+/**
+ * @brief Creates an empty concurrent tree with its own node arena.
+ *
+ * @param slab_nodes Nodes per arena slab, 0 selects BST_ARENA_SLAB_NODES.
+ * @return rcu_tree_ptr_t Pointer to the tree, or NULL if allocation fails.
+ */
+rcu_tree_ptr_t create_rcu_tree(size_t slab_nodes);
+
+/**
+ * @brief Frees the tree and every node.  No reader may be inside a read section.
+ *
+ * @param tree Pointer to the tree (NULL is ignored).
+ */
+void destroy_rcu_tree(rcu_tree_ptr_t tree);
+
+/**
+ * @brief Writer: inserts a reading and publishes the new version.  Only one thread may insert.
+ *
+ * @param tree Pointer to the tree.
+ * @param data The temp_humid_data_t data to be inserted.
+ * @return int 0 on success, -1 if allocation failed (the tree is unchanged).
+ */
+int rcu_insert(rcu_tree_ptr_t tree, temp_humid_data_t data);
+
+/**
+ * @brief Writer: waits until every node retired so far has been reclaimed.
+ *
+ * @param tree Pointer to the tree.
+ */
+void rcu_synchronize(rcu_tree_ptr_t tree);
+
+/**
+ * @brief Claims a reader slot for the calling thread.
+ *
+ * @param tree Pointer to the tree.
+ * @return int Slot to pass to the read functions, or -1 if all RCU_MAX_READERS slots are taken.
+ */
+int rcu_register_reader(rcu_tree_ptr_t tree);
+
+/**
+ * @brief Releases a reader slot.  The reader must not be inside a read section.
+ *
+ * Does nothing for a slot outside 0 .. RCU_MAX_READERS-1.
+ *
+ * @param tree Pointer to the tree.
+ * @param slot Slot returned by rcu_register_reader().
+ */
+void rcu_unregister_reader(rcu_tree_ptr_t tree, int slot);
+
+/**
+ * @brief Enters a read section and returns the current version of the tree.
+ *
+ * The returned tree can be walked with any read-only bst.h function (search_tree,
+ * range_query, aggregate_range, ...) until rcu_read_unlock().
+ *
+ * A slot outside 0 .. RCU_MAX_READERS-1, such as the -1 of a failed
+ * rcu_register_reader(), enters no read section and reads as an empty tree.
+ *
+ * @param tree Pointer to the tree.
+ * @param slot Slot returned by rcu_register_reader().
+ * @return bst_node_ptr_t Root of the snapshot, NULL if the tree is empty or slot is invalid.
+ */
+bst_node_ptr_t rcu_read_lock(rcu_tree_ptr_t tree, int slot);
+
+/**
+ * @brief Leaves a read section.  Nodes of the snapshot must not be used afterwards.
+ *
+ * Does nothing for a slot outside 0 .. RCU_MAX_READERS-1.
+ *
+ * @param tree Pointer to the tree.
+ * @param slot Slot returned by rcu_register_reader().
+ */
+void rcu_read_unlock(rcu_tree_ptr_t tree, int slot);
+
+/**
+ * @brief Looks up a timestamp and copies the reading out, inside its own read section.
+ *
+ * @param tree Pointer to the tree.
+ * @param slot Slot returned by rcu_register_reader().
+ * @param timestamp The timestamp to search for.
+ * @param out Receives the reading if found.
+ * @return bool True if a reading with that timestamp exists.
+ */
+bool rcu_search(rcu_tree_ptr_t tree, int slot, time_t timestamp, temp_humid_data_t* out);
+
+/**
+ * @brief range_query() on the current version, inside its own read section.
+ *
+ * @param tree Pointer to the tree.
+ * @param slot Slot returned by rcu_register_reader().
+ * @param low Lower bound of the window.
+ * @param high Upper bound of the window.
+ * @param flags BST_RANGE_EXCLUDE_LOW and/or BST_RANGE_EXCLUDE_HIGH to make a bound exclusive.
+ * @param limit Maximum number of readings to visit, 0 for no limit.
+ * @param visit Visitor called for each reading.
+ * @param ctx Caller context passed through to the visitor.
+ * @return size_t Number of readings visited.
+ */
+size_t rcu_range_query(rcu_tree_ptr_t tree, int slot, time_t low, time_t high, int flags, size_t limit,
+                       bst_visitor_t visit, void* ctx);
+
+#endif
@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+#include "bst_shard.h"
+
+#define SHARD_MAX       256         // most shards an index may have
+#define SHARD_SPIN      64          // empty polls before an idle worker starts sleeping
+#define SHARD_IDLE_NS   50000       // sleep between polls of an idle worker
+
+// Lets shard_range_query() tell a visitor stop from the end of a window
+typedef struct {
+    bst_visitor_t visit;
+    void* ctx;
+    int stopped;
+} shard_visit_t;
+
+// Floor division, so negative timestamps fall in the bucket below zero
+static time_t bucket_of(time_t timestamp, time_t width) {
+    time_t bucket = timestamp / width;
+    if (timestamp % width < 0) bucket--;
+    return bucket;
+}
+
+static shard_t* shard_of(shard_index_ptr_t index, time_t timestamp) {
+    time_t slot = bucket_of(timestamp, index->bucket_seconds) % index->nshards;
+    if (slot < 0) slot += index->nshards;
+    return &index->shards[slot];
+}
+
+// Smallest timestamp >= timestamp in the tree
+static int first_at_or_after(bst_node_ptr_t tree, time_t timestamp, time_t* out) {
+    int found = 0;
+    while (tree != NULL) {
+        if (tree->data.timestamp >= timestamp) {
+            *out = tree->data.timestamp;
+            found = 1;
+            tree = tree->left;
+        } else {
+            tree = tree->right;
+        }
+    }
+    return found;
+}
+
+static int forward_visit(const temp_humid_data_t* data, void* ctx) {
+    shard_visit_t* fwd = (shard_visit_t*)ctx;
+    if (fwd->visit(data, fwd->ctx) != 0) {
+        fwd->stopped = 1;
+        return 1;
+    }
+    return 0;
+}
+
+static void* shard_worker(void* arg) {
+    shard_t* shard = (shard_t*)arg;
+    temp_humid_data_t batch[SHARD_BATCH];
+    int idle = 0;
+
+    for (;;) {
+        size_t got = spsc_pop(shard->ring, batch, SHARD_BATCH);
+        if (got > 0) {
+            size_t inserted = 0;
+            for (size_t k = 0; k < got; k++) {
+                if (insert_node_policy(&shard->tree, batch[k], shard->arena, BST_DUP_CHAIN) >= 0) {
+                    inserted++;
+                }
+            }
+            // failed first, then applied with release: a flush that sees the count
+            // also sees the tree it describes and the failures of the same batch
+            atomic_fetch_add_explicit(&shard->failed, got - inserted, memory_order_relaxed);
+            atomic_fetch_add_explicit(&shard->applied, inserted, memory_order_release);
+            idle = 0;
+        } else if (spsc_drained(shard->ring)) {
+            break;
+        } else if (++idle < SHARD_SPIN) {
+            sched_yield();
+        } else {
+            struct timespec pause = {0, SHARD_IDLE_NS};
+            nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+
+static void push_outbox(shard_t* shard) {
+    size_t pushed = 0;
+    while (pushed < shard->pending) {
+        pushed += spsc_push(shard->ring, &shard->outbox[pushed], shard->pending - pushed);
+        if (pushed < shard->pending) {
+            sched_yield();      // worker is behind, give it the core
+        }
+    }
+    shard->sent += shard->pending;
+    shard->pending = 0;
+}
+
+shard_index_ptr_t create_shard_index(int nshards, time_t bucket_seconds) {
+    if (nshards < 1 || nshards > SHARD_MAX || bucket_seconds < 1) {
+        return NULL;
+    }
+
+    shard_index_ptr_t index = (shard_index_ptr_t)malloc(sizeof(shard_index_t));
+    size_t bytes = (nshards * sizeof(shard_t) + SPSC_CACHE_LINE - 1) / SPSC_CACHE_LINE * SPSC_CACHE_LINE;
+    shard_t* shards = (shard_t*)aligned_alloc(SPSC_CACHE_LINE, bytes);
+    if (index == NULL || shards == NULL) {
+        printf("Error! Failed to allocate memory for function[create_shard_index].\n");
+        free(index);
+        free(shards);
+        return NULL;
+    }
+    memset(shards, 0, bytes);
+    index->shards = shards;
+    index->nshards = nshards;
+    index->started = 0;
+    index->bucket_seconds = bucket_seconds;
+
+    for (int s = 0; s < nshards; s++) {
+        shard_t* shard = &shards[s];
+        atomic_init(&shard->applied, 0);
+        atomic_init(&shard->failed, 0);
+        shard->arena = create_arena(0);
+        shard->ring = create_spsc_ring(SHARD_RING_CAPACITY);
+        if (shard->arena == NULL || shard->ring == NULL
+            || pthread_create(&shard->thread, NULL, shard_worker, shard) != 0) {
+            destroy_arena(shard->arena);
+            destroy_spsc_ring(shard->ring);
+            shard->arena = NULL;
+            shard->ring = NULL;
+            destroy_shard_index(index);
+            return NULL;
+        }
+        index->started++;
+    }
+    return index;
+}
+
+void destroy_shard_index(shard_index_ptr_t index) {
+    if (index == NULL) return;
+
+    for (int s = 0; s < index->started; s++) {
+        spsc_close(index->shards[s].ring);
+    }
+    for (int s = 0; s < index->started; s++) {
+        shard_t* shard = &index->shards[s];
+        pthread_join(shard->thread, NULL);
+        destroy_spsc_ring(shard->ring);
+        destroy_arena(shard->arena);
+    }
+    free(index->shards);
+    free(index);
+}
+
+void shard_insert(shard_index_ptr_t index, const temp_humid_data_t* data, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        shard_t* shard = shard_of(index, data[i].timestamp);
+        shard->outbox[shard->pending++] = data[i];
+        if (shard->pending == SHARD_BATCH) {
+            push_outbox(shard);
+        }
+    }
+}
+
+int shard_flush(shard_index_ptr_t index) {
+    for (int s = 0; s < index->nshards; s++) {
+        push_outbox(&index->shards[s]);
+    }
+    for (int s = 0; s < index->nshards; s++) {
+        shard_t* shard = &index->shards[s];
+        for (;;) {
+            size_t applied = atomic_load_explicit(&shard->applied, memory_order_acquire);
+            if (applied + atomic_load_explicit(&shard->failed, memory_order_relaxed) == shard->sent) break;
+            sched_yield();
+        }
+    }
+    return (shard_failed(index) == 0) ? 0 : -1;
+}
+
+bst_node_ptr_t shard_search(shard_index_ptr_t index, time_t timestamp) {
+    return search_tree(shard_of(index, timestamp)->tree, timestamp);
+}
+
+size_t shard_range_query(shard_index_ptr_t index, time_t low, time_t high, int flags, size_t limit,
+                         bst_visitor_t visit, void* ctx) {
+    if (low > high) return 0;
+    if (flags & BST_RANGE_EXCLUDE_LOW) {
+        if (low == high) return 0;
+        low++;
+    }
+    if (flags & BST_RANGE_EXCLUDE_HIGH) {
+        if (low == high) return 0;
+        high--;
+    }
+
+    // next[s] is the first timestamp of shard s not yet visited.  The shard with the
+    // smallest one owns the next bucket, so buckets are visited in time order
+    time_t next[SHARD_MAX];
+    int live[SHARD_MAX];
+    for (int s = 0; s < index->nshards; s++) {
+        live[s] = first_at_or_after(index->shards[s].tree, low, &next[s]) && next[s] <= high;
+    }
+
+    shard_visit_t fwd = {visit, ctx, 0};
+    size_t visited = 0;
+    for (;;) {
+        int best = -1;
+        for (int s = 0; s < index->nshards; s++) {
+            if (live[s] && (best < 0 || next[s] < next[best])) best = s;
+        }
+        if (best < 0) break;
+
+        // Rest of this bucket, clipped to the window
+        time_t start = bucket_of(next[best], index->bucket_seconds) * index->bucket_seconds;
+        time_t last = ((uint64_t)high - (uint64_t)start < (uint64_t)index->bucket_seconds)
+                      ? high : start + (index->bucket_seconds - 1);
+        visited += range_query(index->shards[best].tree, next[best], last, BST_RANGE_INCLUSIVE,
+                               limit ? limit - visited : 0, forward_visit, &fwd);
+        if (fwd.stopped || (limit && visited >= limit)) break;
+
+        live[best] = last < high && first_at_or_after(index->shards[best].tree, last + 1, &next[best])
+                     && next[best] <= high;
+    }
+    return visited;
+}
+
+uint64_t shard_aggregate(shard_index_ptr_t index, time_t low, time_t high, int flags, bst_agg_t* out) {
+    aggregate_range(index->shards[0].tree, low, high, flags, out);
+    for (int s = 1; s < index->nshards; s++) {
+        bst_agg_t part;
+        if (aggregate_range(index->shards[s].tree, low, high, flags, &part) == 0) continue;
+        bst_agg_merge(out, &part);
+    }
+    return out->count;
+}
+
+size_t shard_count(shard_index_ptr_t index) {
+    size_t count = 0;
+    for (int s = 0; s < index->nshards; s++) {
+        count += atomic_load_explicit(&index->shards[s].applied, memory_order_relaxed);
+    }
+    return count;
+}
+
+size_t shard_failed(shard_index_ptr_t index) {
+    size_t count = 0;
+    for (int s = 0; s < index->nshards; s++) {
+        count += atomic_load_explicit(&index->shards[s].failed, memory_order_relaxed);
+    }
+    return count;
+}
@@ -0,0 +1,144 @@
+/**
+* bst_shard.h - Header file for the time-bucketed sharded timestamp index
+ *
+ * @file:               bst_shard.h
+ * @author:            	Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Splits the timestamp index over several independent trees so ingest can use
+ * several cores.  Time is cut into fixed buckets (a minute, say) and bucket b lives
+ * in shard b % nshards, so a run of time-ordered readings moves from shard to shard
+ * as it crosses bucket boundaries.  Each shard has its own arena, its own tree and
+ * its own worker thread, fed by a lock-free SPSC ring; the thread calling
+ * shard_insert() only sorts readings into per-shard batches.
+ *
+ * Time-ordered ingest (the acquisition thread, WAL replay, a CSV log) only keeps
+ * every worker busy when a bucket holds no more than a batch or so of readings.
+ * With wide buckets the stream sits in one bucket, and so on one worker, for
+ * thousands of readings at a time, which serializes ingest.  Wide buckets do save
+ * work on range queries, which make one tree query per bucket they cross.
+ *
+ * Queries run on the calling thread once shard_flush() has let the workers catch
+ * up.  A range query visits the shards bucket by bucket in time order, so results
+ * come out sorted without buffering them.
+ *
+ */
+
+#ifndef _BST_SHARD_H
+#define _BST_SHARD_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "bst.h"
+#include "spsc_ring.h"
+
+#define SHARD_BUCKET_MINUTE 60          // spreads time-ordered readings a few per second or slower
+#define SHARD_BUCKET_HOUR   3600
+#define SHARD_BUCKET_DAY    86400
+#define SHARD_BATCH         256         // readings staged per shard before a push
+#define SHARD_RING_CAPACITY 8192        // readings in flight to each worker
+
+// One shard.  Only its worker touches tree and arena while readings are in flight.
+typedef struct shard {
+    bst_node_ptr_t tree;
+    bst_arena_ptr_t arena;
+    spsc_ring_ptr_t ring;
+    pthread_t thread;
+    size_t sent;                                    // readings pushed, dispatcher side
+    size_t pending;                                 // readings staged in outbox
+    temp_humid_data_t outbox[SHARD_BATCH];
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t applied;  // readings inserted, worker side
+    atomic_size_t failed;                           // readings dropped on allocation failure, worker side
+} shard_t;
+
+typedef struct shard_index {
+    shard_t *shards;
+    int nshards;
+    int started;            // worker threads running
+    time_t bucket_seconds;
+} shard_index_t, *shard_index_ptr_t;
+
+/**
+ * @brief Creates a sharded index and starts one worker thread per shard.
+ *
+ * @param nshards Number of shards (and worker threads), at least 1.
+ * @param bucket_seconds Width of a time bucket, e.g. SHARD_BUCKET_MINUTE.  For ingest
+ * in time order keep it to about SHARD_BATCH readings' worth of time.
+ * @return shard_index_ptr_t The index, or NULL on failure.
+ */
+shard_index_ptr_t create_shard_index(int nshards, time_t bucket_seconds);
+
+/**
+ * @brief Stops the workers and frees every shard.
+ *
+ * @param index The index (NULL is ignored).
+ */
+void destroy_shard_index(shard_index_ptr_t index);
+
+/**
+ * @brief Hands readings to the shards that own their buckets.  Returns once they
+ * are queued; call shard_flush() before querying.  Call from one thread at a time.
+ *
+ * @param index The index.
+ * @param data Readings to insert.
+ * @param n Number of readings.
+ */
+void shard_insert(shard_index_ptr_t index, const temp_humid_data_t* data, size_t n);
+
+/**
+ * @brief Pushes staged readings and waits until every worker has inserted them.
+ *
+ * A reading whose node could not be allocated is dropped by its worker and counted
+ * by shard_failed(), not shard_count().
+ *
+ * @param index The index.
+ * @return int 0 if every reading handed to the index so far went in, -1 if any was dropped.
+ */
+int shard_flush(shard_index_ptr_t index);
+
+/**
+ * @brief Looks up a timestamp in the shard that owns it.
+ *
+ * @param index The index, flushed.
+ * @param timestamp The timestamp to search for.
+ * @return bst_node_ptr_t The matching node, or NULL if not found.
+ */
+bst_node_ptr_t shard_search(shard_index_ptr_t index, time_t timestamp);
+
+/**
+ * @brief Visits, in timestamp order, every reading in the window across all shards.
+ *
+ * Same window, flags and limit as range_query().
+ *
+ * @param index The index, flushed.
+ * @return size_t Number of readings visited.
+ */
+size_t shard_range_query(shard_index_ptr_t index, time_t low, time_t high, int flags, size_t limit,
+                         bst_visitor_t visit, void* ctx);
+
+/**
+ * @brief Same as aggregate_range(), combined over all shards.
+ *
+ * @param index The index, flushed.
+ * @return uint64_t Number of readings in the window.
+ */
+uint64_t shard_aggregate(shard_index_ptr_t index, time_t low, time_t high, int flags, bst_agg_t* out);
+
+/**
+ * @brief Number of readings inserted so far, over all shards.
+ *
+ * @param index The index.
+ * @return size_t Reading count.
+ */
+size_t shard_count(shard_index_ptr_t index);
+
+/**
+ * @brief Number of readings dropped so far because a node could not be allocated.
+ *
+ * @param index The index.
+ * @return size_t Dropped reading count.
+ */
+size_t shard_failed(shard_index_ptr_t index);
+
+#endif
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "bst_snapshot.h"
+#include "fsutil.h"
+
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+
+static uint64_t align_up(uint64_t offset) {
+    return (offset + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+}
+
+// fwrite() of the whole array, with the unused slot 0 written as zeros
+static int write_array(FILE* out, const void* array, size_t elem_size, size_t size) {
+    static const char zeros[SNAPSHOT_ALIGN];
+    if (fwrite(zeros, 1, elem_size, out) != elem_size) return -1;
+    if (size > 0 && fwrite((const char*)array + elem_size, elem_size, size, out) != size) return -1;
+    return 0;
+}
+
+static int pad_to(FILE* out, uint64_t offset) {
+    static const char zeros[SNAPSHOT_ALIGN];
+    long pos = ftell(out);
+    if (pos < 0 || (uint64_t)pos > offset) return -1;
+    size_t pad = (size_t)(offset - (uint64_t)pos);
+    return (fwrite(zeros, 1, pad, out) == pad) ? 0 : -1;
+}
+
+int save_snapshot(const bst_frozen_t* frozen, const char* path) {
+    snapshot_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = SNAPSHOT_BYTE_ORDER;
+    header.key_size = sizeof(time_t);
+    header.record_size = sizeof(temp_humid_data_t);
+    header.size = frozen->size;
+    header.keys_offset = align_up(sizeof(header));
+    header.data_offset = align_up(header.keys_offset + (frozen->size + 1) * sizeof(time_t));
+    header.file_size = header.data_offset + (frozen->size + 1) * sizeof(temp_humid_data_t);
+
+    size_t len = strlen(path);
+    char* tmp_path = (char*)malloc(len + 5);
+    if (tmp_path == NULL) {
+        printf("Error! Failed to allocate memory for function[save_snapshot].\n");
+        return -1;
+    }
+    memcpy(tmp_path, path, len);
+    memcpy(tmp_path + len, ".tmp", 5);
+
+    FILE* out = fopen(tmp_path, "wb");
+    if (out == NULL) {
+        free(tmp_path);
+        return -1;
+    }
+    int failed = fwrite(&header, sizeof(header), 1, out) != 1
+        || pad_to(out, header.keys_offset) != 0
+        || write_array(out, frozen->keys, sizeof(time_t), frozen->size) != 0
+        || pad_to(out, header.data_offset) != 0
+        || write_array(out, frozen->data, sizeof(temp_humid_data_t), frozen->size) != 0
+        || fflush(out) != 0
+        || fsync(fileno(out)) != 0;
+    failed |= (fclose(out) != 0);
+    if (failed || rename(tmp_path, path) != 0) {
+        remove(tmp_path);
+        free(tmp_path);
+        return -1;
+    }
+    free(tmp_path);
+    return sync_parent_dir(path);
+}
+
+bst_snapshot_ptr_t open_snapshot(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (uint64_t)st.st_size < sizeof(snapshot_header_t)) {
+        close(fd);
+        return NULL;
+    }
+    size_t map_size = (size_t)st.st_size;
+    void* map = mmap(NULL, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);     // the mapping keeps the file open
+    if (map == MAP_FAILED) {
+        return NULL;
+    }
+
+    // Every offset is checked against the real file size before anything is read through it
+    const snapshot_header_t* header = (const snapshot_header_t*)map;
+    uint64_t size = header->size;
+    int valid = memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) == 0
+        && header->version == SNAPSHOT_VERSION
+        && header->byte_order == SNAPSHOT_BYTE_ORDER
+        && header->key_size == sizeof(time_t)
+        && header->record_size == sizeof(temp_humid_data_t)
+        && header->file_size == map_size
+        && size < map_size
+        && header->keys_offset % SNAPSHOT_ALIGN == 0
+        && header->data_offset % SNAPSHOT_ALIGN == 0
+        && header->keys_offset >= sizeof(snapshot_header_t)
+        && header->keys_offset <= header->data_offset
+        && header->data_offset <= map_size
+        // Divide rather than multiply so a huge size can't wrap around and pass
+        && size + 1 <= (header->data_offset - header->keys_offset) / sizeof(time_t)
+        && size + 1 <= (map_size - header->data_offset) / sizeof(temp_humid_data_t);
+    if (!valid) {
+        munmap(map, map_size);
+        return NULL;
+    }
+
+    bst_snapshot_ptr_t snapshot = (bst_snapshot_ptr_t)malloc(sizeof(bst_snapshot_t));
+    if (snapshot == NULL) {
+        printf("Error! Failed to allocate memory for function[open_snapshot].\n");
+        munmap(map, map_size);
+        return NULL;
+    }
+    snapshot->frozen.keys = (time_t*)((char*)map + header->keys_offset);
+    snapshot->frozen.data = (temp_humid_data_t*)((char*)map + header->data_offset);
+    snapshot->frozen.size = (size_t)size;
+    snapshot->map = map;
+    snapshot->map_size = map_size;
+    return snapshot;
+}
+
+void close_snapshot(bst_snapshot_ptr_t snapshot) {
+    if (snapshot == NULL) return;
+
+    munmap(snapshot->map, snapshot->map_size);
+    free(snapshot);
+}
@@ -0,0 +1,79 @@
+/**
+* bst_snapshot.h - Header file for on-disk snapshots of the frozen timestamp index
+ *
+ * @file:               bst_snapshot.h
+ * @author:            	Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Saves a frozen index to a file and maps it back read-only.  The file holds no
+ * pointers: a header gives the byte offsets of the Eytzinger keys[] and data[]
+ * arrays, which are stored exactly as they sit in memory.  Opening a snapshot is
+ * one mmap() plus a header check, whatever the number of readings, and pages are
+ * read in from disk by the queries that touch them.
+ *
+ * Snapshots use the byte order and type sizes of the machine that wrote them; a
+ * file from a different layout is rejected when opened.
+ *
+ */
+
+#ifndef _BST_SNAPSHOT_H
+#define _BST_SNAPSHOT_H
+
+#include <stdint.h>
+#include "bst_frozen.h"
+
+#define SNAPSHOT_MAGIC      "HW5SNAP"   // first 8 bytes of every snapshot, NUL included
+#define SNAPSHOT_VERSION    1
+#define SNAPSHOT_ALIGN      64          // keys[] and data[] start on cache-line boundaries
+
+// File header, at offset 0
+typedef struct snapshot_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;        // 0x01020304 as written by the saving machine
+    uint32_t key_size;          // sizeof(time_t)
+    uint32_t record_size;       // sizeof(temp_humid_data_t)
+    uint64_t size;              // number of readings
+    uint64_t keys_offset;       // (size + 1) keys, slot 0 unused
+    uint64_t data_offset;       // (size + 1) readings, slot 0 unused
+    uint64_t file_size;
+} snapshot_header_t;
+
+// Open snapshot.  frozen points into the mapping and works with every
+// bst_frozen.h query except destroy_frozen().
+typedef struct bst_snapshot {
+    bst_frozen_t frozen;
+    void *map;
+    size_t map_size;
+} bst_snapshot_t, *bst_snapshot_ptr_t;
+
+/**
+ * @brief Writes a frozen index to a snapshot file.  The file is written under a
+ * temporary name, synced and then renamed, so an existing snapshot at path is
+ * only ever replaced by a complete one.  The directory is synced after the rename
+ * so the new snapshot survives a crash.
+ *
+ * @param frozen Pointer to the frozen index.
+ * @param path File to create or replace.
+ * @return int 0 on success, -1 on failure.
+ */
+int save_snapshot(const bst_frozen_t* frozen, const char* path);
+
+/**
+ * @brief Maps a snapshot file read-only.
+ *
+ * @param path Snapshot file written by save_snapshot().
+ * @return bst_snapshot_ptr_t The open snapshot, or NULL if the file cannot be
+ * opened or is not a valid snapshot for this machine.
+ */
+bst_snapshot_ptr_t open_snapshot(const char* path);
+
+/**
+ * @brief Unmaps a snapshot.  Readings returned by its queries are invalid afterwards.
+ *
+ * @param snapshot The open snapshot (NULL is ignored).
+ */
+void close_snapshot(bst_snapshot_ptr_t snapshot);
+
+#endif
@@ -0,0 +1,189 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "colstore.h"
+
+#define FIXED_MAX   (INT16_MAX >> COLSTORE_FRAC_BITS)
+#define FIXED_MIN   (INT16_MIN >> COLSTORE_FRAC_BITS)
+
+static int colstore_reserve(colstore_ptr_t store, size_t capacity);
+
+colstore_ptr_t create_colstore(size_t capacity) {
+    colstore_ptr_t store = (colstore_ptr_t)calloc(1, sizeof(colstore_t));
+    if (store == NULL) {
+        printf("Error! Failed to allocate memory for function[create_colstore].\n");
+        return NULL;
+    }
+    if (colstore_reserve(store, capacity) != 0) {
+        printf("Error! Failed to allocate memory for function[create_colstore].\n");
+        destroy_colstore(store);
+        return NULL;
+    }
+    return store;
+}
+
+void destroy_colstore(colstore_ptr_t store) {
+    if (store == NULL) return;
+
+    free(store->block_base);
+    free(store->ts_delta);
+    free(store->temp);
+    free(store->humid);
+    free(store);
+}
+
+// Grows every column to hold at least capacity readings (rounded up to whole blocks)
+static int colstore_reserve(colstore_ptr_t store, size_t capacity) {
+    if (capacity <= store->capacity) return 0;
+
+    size_t grown = store->capacity * 2;
+    if (grown < capacity) grown = capacity;
+    grown = (grown + COLSTORE_BLOCK - 1) / COLSTORE_BLOCK * COLSTORE_BLOCK;
+
+    time_t* block_base = (time_t*)realloc(store->block_base, grown / COLSTORE_BLOCK * sizeof(time_t));
+    if (block_base == NULL) return -1;
+    store->block_base = block_base;
+
+    uint32_t* ts_delta = (uint32_t*)realloc(store->ts_delta, grown * sizeof(uint32_t));
+    if (ts_delta == NULL) return -1;
+    store->ts_delta = ts_delta;
+
+    int16_t* temp = (int16_t*)realloc(store->temp, grown * sizeof(int16_t));
+    if (temp == NULL) return -1;
+    store->temp = temp;
+
+    int16_t* humid = (int16_t*)realloc(store->humid, grown * sizeof(int16_t));
+    if (humid == NULL) return -1;
+    store->humid = humid;
+
+    store->capacity = grown;
+    return 0;
+}
+
+// Appends already encoded columns
+static int colstore_push(colstore_ptr_t store, time_t timestamp, int16_t temp, int16_t humid) {
+    size_t i = store->size;
+
+    if (i > 0 && timestamp < colstore_timestamp(store, i - 1)) return -1;
+    if (colstore_reserve(store, i + 1) != 0) {
+        printf("Error! Failed to allocate memory for function[colstore_push].\n");
+        return -1;
+    }
+
+    size_t block = i / COLSTORE_BLOCK;
+    if (i % COLSTORE_BLOCK == 0) {
+        store->block_base[block] = timestamp;
+    }
+    if ((uint64_t)(timestamp - store->block_base[block]) > UINT32_MAX) return -1;
+
+    store->ts_delta[i] = (uint32_t)(timestamp - store->block_base[block]);
+    store->temp[i] = temp;
+    store->humid[i] = humid;
+    store->size++;
+    return 0;
+}
+
+int colstore_append(colstore_ptr_t store, const temp_humid_data_t* data) {
+    if (data->temp > FIXED_MAX || data->humid > FIXED_MAX) return -1;
+    return colstore_push(store, data->timestamp,
+                         (int16_t)(data->temp << COLSTORE_FRAC_BITS),
+                         (int16_t)(data->humid << COLSTORE_FRAC_BITS));
+}
+
+int colstore_append_float(colstore_ptr_t store, time_t timestamp, float temp, float humid) {
+    if (temp < FIXED_MIN || temp >= FIXED_MAX + 1 || humid < FIXED_MIN || humid >= FIXED_MAX + 1) return -1;
+    return colstore_push(store, timestamp, COLSTORE_TO_FIXED(temp), COLSTORE_TO_FIXED(humid));
+}
+
+time_t colstore_timestamp(const colstore_t* store, size_t i) {
+    return store->block_base[i / COLSTORE_BLOCK] + store->ts_delta[i];
+}
+
+// Fixed point to whole units, rounding to nearest and clamping negatives to 0
+static uint32_t fixed_to_units(int16_t v) {
+    if (v <= 0) return 0;
+    return (uint32_t)((v + (1 << (COLSTORE_FRAC_BITS - 1))) >> COLSTORE_FRAC_BITS);
+}
+
+void colstore_get(const colstore_t* store, size_t i, temp_humid_data_t* out) {
+    out->timestamp = colstore_timestamp(store, i);
+    out->temp = fixed_to_units(store->temp[i]);
+    out->humid = fixed_to_units(store->humid[i]);
+}
+
+size_t colstore_lower_bound(const colstore_t* store, time_t timestamp) {
+    size_t blocks = (store->size + COLSTORE_BLOCK - 1) / COLSTORE_BLOCK;
+
+    // Last block whose base is below the timestamp, the match is in it or starts the next one
+    size_t lo = 0, hi = blocks;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (store->block_base[mid] < timestamp) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) return 0;
+
+    size_t block = lo - 1;
+    size_t first = block * COLSTORE_BLOCK;
+    size_t last = first + COLSTORE_BLOCK;
+    if (last > store->size) last = store->size;
+
+    // Offsets inside a block are sorted, search them without rebuilding timestamps
+    uint64_t delta = (uint64_t)(timestamp - store->block_base[block]);
+    lo = first;
+    hi = last;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (store->ts_delta[mid] < delta) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+uint64_t colstore_aggregate(const colstore_t* store, time_t low, time_t high, colstore_agg_t* out) {
+    out->count = 0;
+    out->temp_sum = 0;
+    out->humid_sum = 0;
+    out->temp_min = INT16_MAX;
+    out->temp_max = INT16_MIN;
+    out->humid_min = INT16_MAX;
+    out->humid_max = INT16_MIN;
+    if (low > high) return 0;
+
+    size_t first = colstore_lower_bound(store, low);
+    size_t last = (high == INT64_MAX) ? store->size : colstore_lower_bound(store, high + 1);
+    if (first >= last) return 0;
+
+    // Plain loops over the fixed point columns, simple enough for the compiler to vectorize
+    const int16_t* temp = store->temp + first;
+    const int16_t* humid = store->humid + first;
+    size_t n = last - first;
+    int64_t temp_sum = 0, humid_sum = 0;
+    int16_t temp_min = INT16_MAX, temp_max = INT16_MIN;
+    int16_t humid_min = INT16_MAX, humid_max = INT16_MIN;
+
+    for (size_t i = 0; i < n; i++) {
+        temp_sum += temp[i];
+        temp_min = (temp[i] < temp_min) ? temp[i] : temp_min;
+        temp_max = (temp[i] > temp_max) ? temp[i] : temp_max;
+    }
+    for (size_t i = 0; i < n; i++) {
+        humid_sum += humid[i];
+        humid_min = (humid[i] < humid_min) ? humid[i] : humid_min;
+        humid_max = (humid[i] > humid_max) ? humid[i] : humid_max;
+    }
+
+    out->count = n;
+    out->temp_sum = temp_sum;
+    out->humid_sum = humid_sum;
+    out->temp_min = temp_min;
+    out->temp_max = temp_max;
+    out->humid_min = humid_min;
+    out->humid_max = humid_max;
+    return n;
+}
@@ -0,0 +1,127 @@
+/**
+* colstore.h - Header file for the columnar reading store
+ *
+ * @file:               colstore.h
+ * @author:            	Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Append-only struct-of-arrays storage for readings in timestamp order.  Timestamps are
+ * frame-of-reference encoded, each stored as its offset from the first timestamp of its
+ * block rather than from the previous reading, so the offsets in a block stay sorted and
+ * can be binary searched.  temp/humid are kept as 16-bit fixed point, so a reading costs
+ * 8 bytes instead of 16 and each field can be scanned (and vectorized) on its own.
+ *
+ */
+
+#ifndef _COLSTORE_H
+#define _COLSTORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bst.h"
+
+#define COLSTORE_BLOCK      1024    // readings sharing one timestamp base
+#define COLSTORE_FRAC_BITS  6       // temp/humid are signed Q9.6, range [-512, 512)
+
+// Fixed point <-> float for the temp and humid columns
+#define COLSTORE_TO_FIXED(v)    ((int16_t)((v) * (1 << COLSTORE_FRAC_BITS)))
+#define COLSTORE_TO_FLOAT(v)    ((float)(v) / (1 << COLSTORE_FRAC_BITS))
+
+// Columnar store, readings are indexed 0..size-1 in timestamp order
+typedef struct colstore {
+    time_t *block_base;     // first timestamp of each block
+    uint32_t *ts_delta;     // timestamp minus the base of its block
+    int16_t *temp;
+    int16_t *humid;
+    size_t size;
+    size_t capacity;
+} colstore_t, *colstore_ptr_t;
+
+// Aggregates over a window.  Sums, min and max are in fixed point, see COLSTORE_TO_FLOAT().
+typedef struct colstore_agg {
+    uint64_t count;
+    int64_t temp_sum;
+    int64_t humid_sum;
+    int16_t temp_min;
+    int16_t temp_max;
+    int16_t humid_min;
+    int16_t humid_max;
+} colstore_agg_t, *colstore_agg_ptr_t;
+
+/**
+ * @brief Creates an empty columnar store.
+ *
+ * @param capacity Number of readings to reserve room for, the store grows as needed.
+ * @return colstore_ptr_t Pointer to the store, or NULL if allocation fails.
+ */
+colstore_ptr_t create_colstore(size_t capacity);
+
+/**
+ * @brief Frees a columnar store.
+ *
+ * @param store Pointer to the store (NULL is ignored).
+ */
+void destroy_colstore(colstore_ptr_t store);
+
+/**
+ * @brief Appends a reading.  Timestamps must not go backwards.
+ *
+ * @param store Pointer to the store.
+ * @param data Reading to append, temp and humid must fit the fixed point range.
+ * @return int 0 on success, -1 if the reading is out of order or out of range, or allocation fails.
+ */
+int colstore_append(colstore_ptr_t store, const temp_humid_data_t* data);
+
+/**
+ * @brief Appends a reading given as floats, keeping COLSTORE_FRAC_BITS of fraction.
+ *
+ * @param store Pointer to the store.
+ * @param timestamp Timestamp of the reading, must not be before the last one.
+ * @param temp Temperature in degrees C.
+ * @param humid Relative humidity in %.
+ * @return int 0 on success, -1 if the reading is out of order or out of range, or allocation fails.
+ */
+int colstore_append_float(colstore_ptr_t store, time_t timestamp, float temp, float humid);
+
+/**
+ * @brief Returns the timestamp of reading i.
+ *
+ * @param store Pointer to the store.
+ * @param i Index of the reading, less than size.
+ * @return time_t Timestamp of the reading.
+ */
+time_t colstore_timestamp(const colstore_t* store, size_t i);
+
+/**
+ * @brief Decodes reading i, temp and humid are rounded to whole units.
+ *
+ * @param store Pointer to the store.
+ * @param i Index of the reading, less than size.
+ * @param out Receives the reading.
+ */
+void colstore_get(const colstore_t* store, size_t i, temp_humid_data_t* out);
+
+/**
+ * @brief Finds the first reading with a timestamp at or after the given one.
+ *
+ * @param store Pointer to the store.
+ * @param timestamp Timestamp to search for.
+ * @return size_t Index of that reading, or size if there is none.
+ */
+size_t colstore_lower_bound(const colstore_t* store, time_t timestamp);
+
+/**
+ * @brief Computes count, sum, min and max of temp and humid for low <= timestamp <= high.
+ *
+ * Binary searches the window and then scans only the two 16-bit columns.
+ *
+ * @param store Pointer to the store.
+ * @param low Lower bound of the window.
+ * @param high Upper bound of the window.
+ * @param out Receives the aggregates.  count is 0 (and min > max) for an empty window.
+ * @return uint64_t Number of readings inside the window.
+ */
+uint64_t colstore_aggregate(const colstore_t* store, time_t low, time_t high, colstore_agg_t* out);
+
+#endif
@@ -3,9 +3,38 @@
  *
  * Generates random floating point numbers within a specified range
  * Acknowledgement: Code by Thang Nguyen ( https://www.mycompiler.io/view/2go3N4CaLQJ )
+ *
+ * xoshiro256** by David Blackman and Sebastiano Vigna ( https://prng.di.unimi.it/ ),
+ * seeded through splitmix64 as its authors recommend.
  */
 
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include "float_rndm.h"
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Generator state of one thread.  lane[w][l] is word w of lane l, so each word
+// of all lanes loads as one vector
+typedef struct {
+    uint64_t s[4];
+    uint64_t lane[4][FLOAT_RNDM_LANES];
+    bool seeded;
+} rndm_state_t;
+
+static _Thread_local rndm_state_t rndm;
+static atomic_uint_fast64_t default_seeds;   // gives every unseeded thread a different stream
+
+// Helper function prototypes
+static uint64_t splitmix64(uint64_t* x);
+static inline uint64_t rotl(uint64_t x, int k);
+static inline double unit_double(uint64_t x);
+static rndm_state_t* state(void);
+static void step_lanes(rndm_state_t* st, uint64_t out[FLOAT_RNDM_LANES], int lanes);
 
 /**
  * Generate positive random floating point number
@@ -26,8 +55,8 @@ double positive_float_rand_in_range(double pos_a, double pos_b) {
 
     // Random float in [a, b] = a + random float in [0, b - a], with c = b - a.
     // Random float in [0, c] = c * random float in [0, 1].
-    // Random float in [0, 1] = random int / RAND_MAX
-    float_rand = pos_start + (pos_end - pos_start) * ((double)rand() / RAND_MAX);
+    // Random float in [0, 1) comes from the top bits of the generator
+    float_rand = pos_start + (pos_end - pos_start) * unit_double(float_rand_u64());
     return float_rand;
 }
 
@@ -50,3 +79,188 @@ double float_rand_in_range(double a, double b) {
         return positive_float_rand_in_range(a, b);
     }
 }
+
+
+/* float_rand_seed() */
+void float_rand_seed(uint64_t seed) {
+    uint64_t x = seed;
+
+    for (int w = 0; w < 4; w++) {
+        rndm.s[w] = splitmix64(&x);
+    }
+    for (int l = 0; l < FLOAT_RNDM_LANES; l++) {
+        for (int w = 0; w < 4; w++) {
+            rndm.lane[w][l] = splitmix64(&x);
+        }
+    }
+    rndm.seeded = true;
+}
+
+
+/* float_rand_u64() */
+uint64_t float_rand_u64(void) {
+    uint64_t* s = state()->s;
+    const uint64_t result = rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+
+/* float_rand_fill() */
+void float_rand_fill(double* out, size_t n, double a, double b) {
+    rndm_state_t* st = state();
+    const double span = b - a;
+    size_t i = 0;
+
+    // x * 5 and x * 9 are shift-and-adds, so the lanes step with plain integer
+    // vector ops.  The top 52 bits become a double in [1, 2) by setting the
+    // exponent, then 1 is subtracted.  Every build gives the same raw values
+#if defined(__AVX2__)
+    __m256i s0 = _mm256_loadu_si256((const __m256i*) st->lane[0]);
+    __m256i s1 = _mm256_loadu_si256((const __m256i*) st->lane[1]);
+    __m256i s2 = _mm256_loadu_si256((const __m256i*) st->lane[2]);
+    __m256i s3 = _mm256_loadu_si256((const __m256i*) st->lane[3]);
+    const __m256i one_bits = _mm256_set1_epi64x(0x3FF0000000000000LL);
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d vspan = _mm256_set1_pd(span);
+    const __m256d va = _mm256_set1_pd(a);
+    for (; i + FLOAT_RNDM_LANES <= n; i += FLOAT_RNDM_LANES) {
+        __m256i x5 = _mm256_add_epi64(s1, _mm256_slli_epi64(s1, 2));
+        __m256i r = _mm256_or_si256(_mm256_slli_epi64(x5, 7), _mm256_srli_epi64(x5, 57));
+        r = _mm256_add_epi64(r, _mm256_slli_epi64(r, 3));
+        __m256i t = _mm256_slli_epi64(s1, 17);
+        s2 = _mm256_xor_si256(s2, s0);
+        s3 = _mm256_xor_si256(s3, s1);
+        s1 = _mm256_xor_si256(s1, s2);
+        s0 = _mm256_xor_si256(s0, s3);
+        s2 = _mm256_xor_si256(s2, t);
+        s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), _mm256_srli_epi64(s3, 19));
+
+        __m256d u = _mm256_sub_pd(_mm256_castsi256_pd(
+            _mm256_or_si256(_mm256_srli_epi64(r, 12), one_bits)), one);
+        _mm256_storeu_pd(&out[i], _mm256_add_pd(va, _mm256_mul_pd(vspan, u)));
+    }
+    _mm256_storeu_si256((__m256i*) st->lane[0], s0);
+    _mm256_storeu_si256((__m256i*) st->lane[1], s1);
+    _mm256_storeu_si256((__m256i*) st->lane[2], s2);
+    _mm256_storeu_si256((__m256i*) st->lane[3], s3);
+#elif defined(__SSE2__)
+    const __m128i one_bits = _mm_set1_epi64x(0x3FF0000000000000LL);
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d vspan = _mm_set1_pd(span);
+    const __m128d va = _mm_set1_pd(a);
+    size_t start = i;
+    for (int half = 0; half < FLOAT_RNDM_LANES; half += 2) {
+        __m128i s0 = _mm_loadu_si128((const __m128i*) &st->lane[0][half]);
+        __m128i s1 = _mm_loadu_si128((const __m128i*) &st->lane[1][half]);
+        __m128i s2 = _mm_loadu_si128((const __m128i*) &st->lane[2][half]);
+        __m128i s3 = _mm_loadu_si128((const __m128i*) &st->lane[3][half]);
+        for (i = start; i + FLOAT_RNDM_LANES <= n; i += FLOAT_RNDM_LANES) {
+            __m128i x5 = _mm_add_epi64(s1, _mm_slli_epi64(s1, 2));
+            __m128i r = _mm_or_si128(_mm_slli_epi64(x5, 7), _mm_srli_epi64(x5, 57));
+            r = _mm_add_epi64(r, _mm_slli_epi64(r, 3));
+            __m128i t = _mm_slli_epi64(s1, 17);
+            s2 = _mm_xor_si128(s2, s0);
+            s3 = _mm_xor_si128(s3, s1);
+            s1 = _mm_xor_si128(s1, s2);
+            s0 = _mm_xor_si128(s0, s3);
+            s2 = _mm_xor_si128(s2, t);
+            s3 = _mm_or_si128(_mm_slli_epi64(s3, 45), _mm_srli_epi64(s3, 19));
+
+            __m128d u = _mm_sub_pd(_mm_castsi128_pd(
+                _mm_or_si128(_mm_srli_epi64(r, 12), one_bits)), one);
+            _mm_storeu_pd(&out[i + half], _mm_add_pd(va, _mm_mul_pd(vspan, u)));
+        }
+        _mm_storeu_si128((__m128i*) &st->lane[0][half], s0);
+        _mm_storeu_si128((__m128i*) &st->lane[1][half], s1);
+        _mm_storeu_si128((__m128i*) &st->lane[2][half], s2);
+        _mm_storeu_si128((__m128i*) &st->lane[3][half], s3);
+    }
+#endif
+
+    uint64_t r[FLOAT_RNDM_LANES];
+    for (; i + FLOAT_RNDM_LANES <= n; i += FLOAT_RNDM_LANES) {
+        step_lanes(st, r, FLOAT_RNDM_LANES);
+        for (int l = 0; l < FLOAT_RNDM_LANES; l++) {
+            out[i + l] = a + span * unit_double(r[l]);
+        }
+    }
+
+    // Remainder: step only the lanes that produce a value
+    if (i < n) {
+        int rest = (int) (n - i);
+        step_lanes(st, r, rest);
+        for (int l = 0; l < rest; l++) {
+            out[i + l] = a + span * unit_double(r[l]);
+        }
+    }
+}
+
+
+// Helper Functions
+
+/**
+ * splitmix64() - expands a seed into well-mixed generator words
+ *
+ * @param x running seed, advanced by the call
+ * @return the next word
+ */
+static uint64_t splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * unit_double() - maps the top 52 bits of x to a double in [0, 1)
+ */
+static inline double unit_double(uint64_t x) {
+    uint64_t bits = (x >> 12) | 0x3FF0000000000000ULL;
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d - 1.0;
+}
+
+/**
+ * state() - returns the calling thread's generators, seeding them on first use
+ */
+static rndm_state_t* state(void) {
+    if (!rndm.seeded) {
+        float_rand_seed(atomic_fetch_add_explicit(&default_seeds, 1, memory_order_relaxed));
+    }
+    return &rndm;
+}
+
+/**
+ * step_lanes() - advances the first lanes generators by one step
+ *
+ * @param st generator state
+ * @param out receives one raw value per stepped lane
+ * @param lanes number of lanes to step, starting at lane 0
+ */
+static void step_lanes(rndm_state_t* st, uint64_t out[FLOAT_RNDM_LANES], int lanes) {
+    for (int l = 0; l < lanes; l++) {
+        const uint64_t s1 = st->lane[1][l];
+        const uint64_t t = s1 << 17;
+
+        out[l] = rotl(s1 * 5, 7) * 9;
+        st->lane[2][l] ^= st->lane[0][l];
+        st->lane[3][l] ^= s1;
+        st->lane[1][l] = s1 ^ st->lane[2][l];
+        st->lane[0][l] ^= st->lane[3][l];
+        st->lane[2][l] ^= t;
+        st->lane[3][l] = rotl(st->lane[3][l], 45);
+    }
+}
@@ -3,13 +3,47 @@
  *
  * Generates random floating point numbers within a specified range
  * Acknowledgement: Code by Thang Nguyen ( https://www.mycompiler.io/view/2go3N4CaLQJ )
+ *
+ * Numbers come from a xoshiro256** generator kept per thread, so threads never
+ * share or contend for generator state.  A thread that never calls
+ * float_rand_seed() gets its own default seed.
  */
 
  #ifndef _FLOAT_RNDM_H
  #define _FLOAT_RNDM_H
 
+ #include <stddef.h>
+ #include <stdint.h>
+
+ #define FLOAT_RNDM_LANES 4     // independent generators stepped together by float_rand_fill()
+
  // function prototypes
  double positive_float_rand_in_range(double pos_a, double pos_b);
 double float_rand_in_range(double a, double b);
 
+/**
+ * @brief Seeds the calling thread's generators.  The same seed gives the same sequence.
+ *
+ * @param seed Any 64-bit value.
+ */
+void float_rand_seed(uint64_t seed);
+
+/**
+ * @brief Returns the next raw 64-bit value from the calling thread's generator.
+ *
+ * @return A uniformly distributed 64-bit value.
+ */
+uint64_t float_rand_u64(void);
+
+/**
+ * @brief Fills an array with random doubles in [a, b).  Steps FLOAT_RNDM_LANES
+ * generators side by side, with SSE2/AVX2 when the build enables them.
+ *
+ * @param out Array receiving n values.
+ * @param n Number of values.
+ * @param a One end of the range.
+ * @param b Other end of the range.
+ */
+void float_rand_fill(double* out, size_t n, double a, double b);
+
 #endif
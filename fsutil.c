@@ -0,0 +1,26 @@
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "fsutil.h"
+
+int sync_parent_dir(const char* path) {
+    const char* slash = strrchr(path, '/');
+    char dir[4096];
+
+    if (slash == NULL) {
+        strcpy(dir, ".");
+    } else if (slash == path) {
+        strcpy(dir, "/");
+    } else if ((size_t)(slash - path) < sizeof(dir)) {
+        memcpy(dir, path, slash - path);
+        dir[slash - path] = '\0';
+    } else {
+        return -1;
+    }
+
+    int fd = open(dir, O_RDONLY);
+    if (fd < 0) return -1;
+    int rtn = fsync(fd);
+    close(fd);
+    return rtn;
+}
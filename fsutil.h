@@ -0,0 +1,26 @@
+/**
+* fsutil.h - Header file for shared file system helpers
+ *
+ * @file:               fsutil.h
+ * @author:            	Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Small POSIX helpers shared by the write-ahead log and the snapshot writer.
+ *
+ */
+
+#ifndef _FSUTIL_H
+#define _FSUTIL_H
+
+/**
+ * @brief Flushes the directory holding path, so a file created or renamed there survives a crash.
+ *
+ * A new file is only durable once the directory entry naming it is.
+ *
+ * @param path Path of the file whose directory is synced.
+ * @return 0 on success, -1 on error.
+ */
+int sync_parent_dir(const char* path);
+
+#endif
@@ -0,0 +1,236 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ingest.h"
+
+// Where the tree sink puts readings
+typedef struct {
+    bst_node_ptr_t* tree;
+    bst_arena_ptr_t arena;
+    int failed;                     // set when an insert could not allocate
+} tree_sink_t;
+
+// Batch of parsed readings waiting for the sink
+typedef struct {
+    temp_humid_data_t items[INGEST_BATCH_SIZE];
+    size_t count;
+    ingest_sink_t sink;
+    void* ctx;
+    ingest_stats_t stats;
+    int stopped;
+} ingest_batch_t;
+
+static int parse_csv_line(const char* p, const char* end, temp_humid_data_t* out);
+static const char* parse_uint(const char* p, const char* end, uint64_t* value);
+static void batch_add(ingest_batch_t* batch, const temp_humid_data_t* data);
+static void batch_flush(ingest_batch_t* batch);
+static int tree_sink(const temp_humid_data_t* batch, size_t n, void* ctx);
+
+int ingest_stream(FILE* in, ingest_format_t format, ingest_sink_t sink, void* ctx, ingest_stats_t* stats) {
+    char* buf = (char*)malloc(INGEST_CHUNK);
+    ingest_batch_t* batch = (ingest_batch_t*)malloc(sizeof(ingest_batch_t));
+    if (buf == NULL || batch == NULL) {
+        printf("Error! Failed to allocate memory for function[ingest_stream].\n");
+        free(buf);
+        free(batch);
+        return -1;
+    }
+    batch->count = 0;
+    batch->sink = sink;
+    batch->ctx = ctx;
+    batch->stats.readings = 0;
+    batch->stats.skipped = 0;
+    batch->stopped = 0;
+
+    size_t have = 0;            // bytes in buf, starting with the carry from the last chunk
+    int discarding = 0;         // inside a CSV line longer than the whole chunk
+    int eof = 0;
+    while (!eof && !batch->stopped) {
+        size_t got = fread(buf + have, 1, INGEST_CHUNK - have, in);
+        have += got;
+        eof = (got == 0) || feof(in);
+
+        const char* p = buf;
+        const char* end = buf + have;
+        if (format == INGEST_BINARY) {
+            for (; end - p >= INGEST_RECORD_SIZE && !batch->stopped; p += INGEST_RECORD_SIZE) {
+                temp_humid_data_t data;
+                ingest_decode((const unsigned char*)p, &data);
+                batch_add(batch, &data);
+            }
+            if (eof && p < end && !batch->stopped) {
+                batch->stats.skipped++;     // truncated final record
+            }
+        } else {
+            while (p < end && !batch->stopped) {
+                const char* nl = (const char*)memchr(p, '\n', end - p);
+                if (nl == NULL) {
+                    if (!eof) break;        // partial line, finish it with the next chunk
+                    nl = end;
+                }
+                if (discarding) {
+                    discarding = 0;         // tail of an overlong line, already counted
+                } else {
+                    temp_humid_data_t data;
+                    int parsed = parse_csv_line(p, nl, &data);
+                    if (parsed > 0) {
+                        batch_add(batch, &data);
+                    } else if (parsed < 0) {
+                        batch->stats.skipped++;
+                    }
+                }
+                p = (nl < end) ? nl + 1 : end;
+            }
+            if (p == buf && have == INGEST_CHUNK) {
+                // no newline in a full chunk: drop the line instead of growing the buffer
+                batch->stats.skipped += !discarding;
+                discarding = 1;
+                p = end;
+            }
+        }
+
+        // carry the unfinished line or record to the front for the next read
+        have = end - p;
+        memmove(buf, p, have);
+    }
+
+    int rtn = ferror(in) ? -1 : 0;
+    if (!batch->stopped) {
+        batch_flush(batch);
+    }
+    if (stats != NULL) {
+        *stats = batch->stats;
+    }
+    free(batch);
+    free(buf);
+    return rtn;
+}
+
+int ingest_into_tree(FILE* in, ingest_format_t format, bst_node_ptr_t* tree, bst_arena_ptr_t arena, ingest_stats_t* stats) {
+    tree_sink_t target = {tree, arena, 0};
+    int rtn = ingest_stream(in, format, tree_sink, &target, stats);
+    return target.failed ? -1 : rtn;
+}
+
+int ingest_write(FILE* out, ingest_format_t format, const temp_humid_data_t* data, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (format == INGEST_BINARY) {
+            unsigned char rec[INGEST_RECORD_SIZE];
+            ingest_encode(&data[i], rec);
+            if (fwrite(rec, 1, INGEST_RECORD_SIZE, out) != INGEST_RECORD_SIZE) {
+                return -1;
+            }
+        } else if (fprintf(out, "%lld,%u,%u\n", (long long)data[i].timestamp, data[i].temp, data[i].humid) < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Parses one CSV line without its newline.
+ *
+ * @return 1 for a reading, 0 for a blank line, -1 for a malformed line.
+ */
+static int parse_csv_line(const char* p, const char* end, temp_humid_data_t* out) {
+    uint64_t ts, temp, humid;
+    int negative = 0;
+
+    while (end > p && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) end--;
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    if (p == end) {
+        return 0;
+    }
+
+    if (*p == '-') {
+        negative = 1;
+        p++;
+    }
+    if ((p = parse_uint(p, end, &ts)) == NULL || p == end || *p++ != ',') return -1;
+    if ((p = parse_uint(p, end, &temp)) == NULL || p == end || *p++ != ',') return -1;
+    if ((p = parse_uint(p, end, &humid)) == NULL || p != end) return -1;
+    if (ts > INT64_MAX || temp > UINT32_MAX || humid > UINT32_MAX) return -1;
+
+    out->timestamp = negative ? -(time_t)ts : (time_t)ts;
+    out->temp = (uint32_t)temp;
+    out->humid = (uint32_t)humid;
+    return 1;
+}
+
+/**
+ * @brief Parses digits with an optional fraction, which is dropped.  Spaces around
+ * the number are allowed.
+ *
+ * @return Pointer past the number, or NULL if there are no digits.
+ */
+static const char* parse_uint(const char* p, const char* end, uint64_t* value) {
+    uint64_t v = 0;
+    const char* start;
+
+    while (p < end && *p == ' ') p++;
+    start = p;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        if (v > (UINT64_MAX - 9) / 10) return NULL;
+        v = v * 10 + (uint64_t)(*p - '0');
+    }
+    if (p == start) {
+        return NULL;
+    }
+    if (p < end && *p == '.') {
+        for (p++; p < end && *p >= '0' && *p <= '9'; p++);
+    }
+    while (p < end && *p == ' ') p++;
+    *value = v;
+    return p;
+}
+
+static void batch_add(ingest_batch_t* batch, const temp_humid_data_t* data) {
+    batch->items[batch->count++] = *data;
+    if (batch->count == INGEST_BATCH_SIZE) {
+        batch_flush(batch);
+    }
+}
+
+static void batch_flush(ingest_batch_t* batch) {
+    if (batch->count == 0) {
+        return;
+    }
+    if (batch->sink(batch->items, batch->count, batch->ctx) != 0) {
+        batch->stopped = 1;
+    } else {
+        batch->stats.readings += batch->count;
+    }
+    batch->count = 0;
+}
+
+void ingest_decode(const unsigned char* rec, temp_humid_data_t* out) {
+    uint64_t ts = 0;
+    uint32_t temp = 0, humid = 0;
+
+    for (int i = 7; i >= 0; i--) ts = (ts << 8) | rec[i];
+    for (int i = 3; i >= 0; i--) temp = (temp << 8) | rec[8 + i];
+    for (int i = 3; i >= 0; i--) humid = (humid << 8) | rec[12 + i];
+    out->timestamp = (time_t)(int64_t)ts;
+    out->temp = temp;
+    out->humid = humid;
+}
+
+void ingest_encode(const temp_humid_data_t* data, unsigned char* rec) {
+    uint64_t ts = (uint64_t)(int64_t)data->timestamp;
+
+    for (int i = 0; i < 8; i++) rec[i] = (unsigned char)(ts >> (8 * i));
+    for (int i = 0; i < 4; i++) rec[8 + i] = (unsigned char)(data->temp >> (8 * i));
+    for (int i = 0; i < 4; i++) rec[12 + i] = (unsigned char)(data->humid >> (8 * i));
+}
+
+static int tree_sink(const temp_humid_data_t* batch, size_t n, void* ctx) {
+    tree_sink_t* target = (tree_sink_t*)ctx;
+
+    for (size_t i = 0; i < n; i++) {
+        if (insert_node_policy(target->tree, batch[i], target->arena, BST_DUP_CHAIN) < 0) {
+            target->failed = 1;
+            return 1;
+        }
+    }
+    return 0;
+}
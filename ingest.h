@@ -0,0 +1,100 @@
+/**
+* ingest.h - Header file for streaming ingest of sensor readings
+ *
+ * @file:               ingest.h
+ * @author:            	Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Reads temp_humid_data_t records from a file or stdin in fixed-size chunks and
+ * hands them to a sink in batches, so memory use stays bounded no matter how large
+ * the log is.  Two formats are understood:
+ *
+ *	- CSV: one "timestamp,temp,humid" reading per line.  timestamp is Unix seconds,
+ *	  temp and humid may carry a fraction, which is truncated like the float to
+ *	  uint32_t conversion in main.c.  Lines that do not parse (a header line, for
+ *	  example) are skipped and counted.
+ *	- Binary: INGEST_RECORD_SIZE-byte records, little-endian int64 timestamp
+ *	  followed by uint32 temp and uint32 humid.
+ *
+ */
+
+#ifndef _INGEST_H
+#define _INGEST_H
+
+#include <stdio.h>
+#include "bst.h"
+
+#define INGEST_CHUNK        (1 << 20)   // bytes read from the stream at a time
+#define INGEST_BATCH_SIZE   1024        // readings handed to the sink at a time
+#define INGEST_RECORD_SIZE  16          // bytes per binary record
+
+typedef enum {
+    INGEST_CSV,
+    INGEST_BINARY
+} ingest_format_t;
+
+typedef struct {
+    size_t readings;    // readings in batches the sink accepted
+    size_t skipped;     // malformed CSV lines, or a truncated final binary record
+} ingest_stats_t;
+
+/**
+ * @brief Receives each batch of parsed readings.
+ *
+ * @return 0 to keep reading, nonzero to stop early.
+ */
+typedef int (*ingest_sink_t)(const temp_humid_data_t* batch, size_t n, void* ctx);
+
+/**
+ * @brief Streams readings from in to sink until end of file.
+ *
+ * @param in Stream to read, e.g. a file opened "rb" or stdin.
+ * @param format INGEST_CSV or INGEST_BINARY.
+ * @param sink Called with each batch of at most INGEST_BATCH_SIZE readings.
+ * @param ctx Passed through to sink.
+ * @param stats Receives reading and skip counts, may be NULL.
+ * @return 0 on success (or when the sink stops early), -1 on a read or allocation error.
+ */
+int ingest_stream(FILE* in, ingest_format_t format, ingest_sink_t sink, void* ctx, ingest_stats_t* stats);
+
+/**
+ * @brief Streams readings from in straight into a tree.
+ *
+ * @param in Stream to read.
+ * @param format INGEST_CSV or INGEST_BINARY.
+ * @param tree Pointer to the root pointer of the tree, updated as readings go in.
+ * @param arena Arena for the new nodes, or NULL for malloc.
+ * @param stats Receives reading and skip counts, may be NULL.
+ * @return 0 on success, -1 on a read or allocation error.
+ */
+int ingest_into_tree(FILE* in, ingest_format_t format, bst_node_ptr_t* tree, bst_arena_ptr_t arena, ingest_stats_t* stats);
+
+/**
+ * @brief Writes readings in the given format, e.g. to produce a log for ingest_stream().
+ *
+ * @param out Stream to write.
+ * @param format INGEST_CSV or INGEST_BINARY.
+ * @param data Readings to write.
+ * @param n Number of readings.
+ * @return 0 on success, -1 on a write error.
+ */
+int ingest_write(FILE* out, ingest_format_t format, const temp_humid_data_t* data, size_t n);
+
+/**
+ * @brief Encodes one reading as an INGEST_RECORD_SIZE-byte binary record.
+ *
+ * @param data Reading to encode.
+ * @param rec Receives INGEST_RECORD_SIZE bytes.
+ */
+void ingest_encode(const temp_humid_data_t* data, unsigned char* rec);
+
+/**
+ * @brief Decodes one INGEST_RECORD_SIZE-byte binary record.
+ *
+ * @param rec Record bytes.
+ * @param out Receives the reading.
+ */
+void ingest_decode(const unsigned char* rec, temp_humid_data_t* out);
+
+#endif
@@ -16,23 +16,26 @@
  #include <stdlib.h>
  #include <stdio.h>
  #include <math.h>
- #include <time.h>
 
  #include "float_rndm.h"
  #include "iom361_r2.h"
 
+ #if defined(__AVX2__) || defined(__SSE2__)
+ #include <immintrin.h>
+ #endif
+
  // constants
  //#define _DEBUG_ 1
 
  // global variables
- static uint32_t IOSpace[sizeof(ioreg_t)/ sizeof(uint32_t)];
- static uint32_t* IOSpacePtr;
- static int nsw;						// number of switches
- static int nleds;						// number of LEDs
- static bool isInitialized = false;		// true if IOM361 has been initialized
- static uint32_t errValue = 0xDEADBEEF;	// value returned on error
+ static iom361_dev_t default_dev;			// device behind the base-pointer API
+ static uint32_t* default_base = NULL;		// base address handed out by iom361_initialize()
+ static const uint32_t errValue = 0xDEADBEEF;	// value returned on error
 
  // Helper function prototypes
+ static void init_device(iom361_dev_t* dev, int num_switches, int num_leds);
+ static iom361_dev_t* device_at(uint32_t* base);
+ static void read_sensor_pair(iom361_dev_t* dev, uint32_t* temp, uint32_t* humid);
  static void display_leds(uint32_t value, int num_leds);
  static void display_rgb_leds(uint32_t value);
 
@@ -40,61 +43,92 @@
 
  /* iom361_initialize() */
  uint32_t* iom361_initialize(int num_switches, int num_leds, int* rtn_code) {
-	// initialize global variables
-	nsw = num_switches;
-	nleds = num_leds;
-	IOSpacePtr = (uint32_t*) &IOSpace;
+	init_device(&default_dev, num_switches, num_leds);
+	default_base = (uint32_t*) default_dev.regs;
 
 	#ifdef _DEBUG_
-		printf("INFO [iom361_initialize()]: IOSpacePtr=%p, IOSpace Length=%d\n",
-			IOSpacePtr, sizeof(IOSpace));
+		printf("INFO [iom361_initialize()]: default_base=%p, IOSpace Length=%zu\n",
+			default_base, sizeof(default_dev.regs));
 	#endif
 
-	// initialize the I/O registers
-	iom361_writeReg(IOSpacePtr, LEDS_REG, 0x00000000, NULL);
-	iom361_writeReg(IOSpacePtr, RGB_LED_REG, 0x00000000, NULL);
-	iom361_writeReg(IOSpacePtr, RSVD1_REG, 0x11111111, NULL);
-	iom361_writeReg(IOSpacePtr, RSVD2_REG, 0x22222222, NULL);
-	iom361_writeReg(IOSpacePtr, RSVD3_REG, 0x33333333, NULL);
+	if (rtn_code != NULL)
+		*rtn_code = 0;
+	return default_base;
+ }
+
+ /* iom361_readReg(g) */
+ uint32_t iom361_readReg(uint32_t* base, uint32_t offset, int* rtn_code) {
+	return iom361_devReadReg(device_at(base), offset, rtn_code);
+ }
+
+ /* iom361_readRegs() */
+ int iom361_readRegs(uint32_t* base, uint32_t offset, uint32_t* values, int count, int* rtn_code) {
+	return iom361_devReadRegs(device_at(base), offset, values, count, rtn_code);
+ }
+
+ /* iom361_readSensor1() */
+ void iom361_readSensor1(uint32_t* base, iom361_sample_t* sample, int* rtn_code) {
+	iom361_devReadSensor1(device_at(base), sample, rtn_code);
+ }
+
+ /* iom361_captureSensor1() */
+ int iom361_captureSensor1(uint32_t* base, iom361_ring_t* ring, int n, int* rtn_code) {
+	return iom361_devCaptureSensor1(device_at(base), ring, n, rtn_code);
+ }
+
+ /* iom361_writeReg() */
+ uint32_t iom361_writeReg(uint32_t* base, int offset, uint32_t value, int* rtn_code) {
+	return iom361_devWriteReg(device_at(base), offset, value, rtn_code);
+ }
 
-	_iom361_setSwitches(0x00000000);
-	_iom361_setSensor1(23.5, 75.0);
 
-	// randomize rand()
-	srand(time(NULL));
+ // Per-device API functions
 
+ /* iom361_create() */
+ iom361_dev_t* iom361_create(int num_switches, int num_leds, int* rtn_code) {
+	iom361_dev_t* dev = (iom361_dev_t*) malloc(sizeof(iom361_dev_t));
+	if (dev == NULL) {
+		printf("Error! Failed to allocate memory for function[iom361_create].\n");
+		if (rtn_code != NULL)
+			*rtn_code = 1;
+		return NULL;
+	}
+
+	init_device(dev, num_switches, num_leds);
 	if (rtn_code != NULL)
 		*rtn_code = 0;
-	isInitialized = true;
-	return IOSpacePtr;
+	return dev;
  }
 
- /* iom361_readReg(g) */
- uint32_t iom361_readReg(uint32_t* base, uint32_t offset, int* rtn_code) {
+ /* iom361_destroy() */
+ void iom361_destroy(iom361_dev_t* dev) {
+	free(dev);
+ }
+
+ /* iom361_devReadReg() */
+ uint32_t iom361_devReadReg(iom361_dev_t* dev, uint32_t offset, int* rtn_code) {
 	uint32_t value;
-	uint32_t* ioreg_ptr;
 
-	if (base != IOSpacePtr) {
-		// not pointing to base of IO space
+	if (dev == NULL) {
+		// not pointing to a device
 		if (rtn_code != NULL)
 			*rtn_code = 1;
 		return errValue;
 	}
 
-	if ((offset < 0) || (offset > (sizeof(IOSpace) - sizeof(uint32_t)))) {
+	if (offset > (sizeof(dev->regs) - sizeof(uint32_t))) {
 		// offset is out of range
 		if (rtn_code != NULL)
 			*rtn_code = 2;
 		return errValue;
 	}
 
-	// calculate address and get the value
-	ioreg_ptr = base + (offset / sizeof(uint32_t));
-	value = *ioreg_ptr;
+	// registers are independent, so no ordering is needed beyond atomicity
+	value = atomic_load_explicit(&dev->regs[offset / sizeof(uint32_t)], memory_order_relaxed);
 
 	#ifdef _DEBUG_
-		printf("INFO[iom361_readReg()]: base = %p, offset = %d, ioreg_ptr=%p, value=%08X\n",
-			base, offset, ioreg_ptr, value);
+		printf("INFO[iom361_devReadReg()]: dev = %p, offset = %u, value=%08X\n",
+			(void*) dev, offset, value);
 	#endif
 
 	if (rtn_code != NULL)
@@ -102,18 +136,98 @@
 	return value;
  }
 
- /* iom361_writeReg() */
- uint32_t iom361_writeReg(uint32_t* base, int offset, uint32_t value, int* rtn_code) {
-	uint32_t* ioreg_ptr;
+ /* iom361_devReadRegs() */
+ int iom361_devReadRegs(iom361_dev_t* dev, uint32_t offset, uint32_t* values, int count, int* rtn_code) {
+	if (dev == NULL) {
+		// not pointing to a device
+		if (rtn_code != NULL)
+			*rtn_code = 1;
+		return 0;
+	}
+
+	if ((count <= 0) || (offset > sizeof(dev->regs))
+		|| ((sizeof(dev->regs) - offset) / sizeof(uint32_t) < (size_t) count)) {
+		// block runs past the end of IO space
+		if (rtn_code != NULL)
+			*rtn_code = 2;
+		return 0;
+	}
+
+	if ((offset % sizeof(uint32_t)) != 0) {
+		// offset does not point to start of an I/O register
+		if (rtn_code != NULL)
+			*rtn_code = 3;
+		return 0;
+	}
+
+	// one validation for the whole block, then a straight copy
+	_Atomic uint32_t* ioreg_ptr = &dev->regs[offset / sizeof(uint32_t)];
+	for (int i = 0; i < count; i++) {
+		values[i] = atomic_load_explicit(&ioreg_ptr[i], memory_order_relaxed);
+	}
+
+	if (rtn_code != NULL)
+		*rtn_code = 0;
+	return count;
+ }
+
+ /* iom361_devReadSensor1() */
+ void iom361_devReadSensor1(iom361_dev_t* dev, iom361_sample_t* sample, int* rtn_code) {
+	if (dev == NULL) {
+		// not pointing to a device
+		if (rtn_code != NULL)
+			*rtn_code = 1;
+		return;
+	}
+
+	read_sensor_pair(dev, &sample->temp, &sample->humid);
+	if (rtn_code != NULL)
+		*rtn_code = 0;
+ }
+
+ /* iom361_devCaptureSensor1() */
+ int iom361_devCaptureSensor1(iom361_dev_t* dev, iom361_ring_t* ring, int n, int* rtn_code) {
+	if (dev == NULL) {
+		// not pointing to a device
+		if (rtn_code != NULL)
+			*rtn_code = 1;
+		return 0;
+	}
+
+	if ((ring == NULL) || (ring->buf == NULL) || (ring->capacity == 0) || (n < 0)
+		|| (ring->head >= ring->capacity) || (ring->count > ring->capacity)) {
+		// no place to put the samples, or a ring whose head is not one of its slots
+		if (rtn_code != NULL)
+			*rtn_code = 2;
+		return 0;
+	}
+
+	uint32_t head = ring->head;
+	for (int i = 0; i < n; i++) {
+		read_sensor_pair(dev, &ring->buf[head].temp, &ring->buf[head].humid);
+		if (++head == ring->capacity)
+			head = 0;
+	}
+
+	ring->head = head;
+	ring->count = ((uint32_t) n >= ring->capacity - ring->count) ? ring->capacity : ring->count + (uint32_t) n;
+	if (rtn_code != NULL)
+		*rtn_code = 0;
+	return n;
+ }
 
-	if (base != IOSpacePtr) {
-		// not pointing to base of IO space
+ /* iom361_devWriteReg() */
+ uint32_t iom361_devWriteReg(iom361_dev_t* dev, int offset, uint32_t value, int* rtn_code) {
+	_Atomic uint32_t* ioreg_ptr;
+
+	if (dev == NULL) {
+		// not pointing to a device
 		if (rtn_code != NULL)
 			*rtn_code = 1;
 		return errValue;
 	}
 
-	if ((offset < 0) || (offset > (sizeof(IOSpace) - sizeof(uint32_t)))) {
+	if ((offset < 0) || ((size_t) offset > (sizeof(dev->regs) - sizeof(uint32_t)))) {
 		// offset is out of range
 		if (rtn_code != NULL)
 			*rtn_code = 2;
@@ -133,21 +247,21 @@
 	if (rtn_code != NULL)
 		*rtn_code = 0;
 
-	ioreg_ptr = base + (offset/sizeof(uint32_t));
+	ioreg_ptr = &dev->regs[offset / sizeof(uint32_t)];
 
 	#ifdef _DEBUG_
-		printf("INFO[iom361_writeReg()]: base = %p, offset = %d, ioreg_ptr=%p, value=%08X\n",
-			base, offset, ioreg_ptr, value);
+		printf("INFO[iom361_devWriteReg()]: dev = %p, offset = %d, value=%08X\n",
+			(void*) dev, offset, value);
 	#endif
 
 	switch (offset) {
 		case SWITCHES_REG:	break; // switches are a read-only input
 
-		case LEDS_REG:		*ioreg_ptr = value;
-							display_leds(value, nleds);
+		case LEDS_REG:		atomic_store_explicit(ioreg_ptr, value, memory_order_relaxed);
+							display_leds(value, dev->nleds);
 							break;
 
-		case RGB_LED_REG:	*ioreg_ptr = value;
+		case RGB_LED_REG:	atomic_store_explicit(ioreg_ptr, value, memory_order_relaxed);
 							display_rgb_leds(value);
 							break;
 
@@ -155,13 +269,13 @@
 
 		case HUMID_REG:		break;	// humidity is a read-only input
 
-		case RSVD1_REG:		*ioreg_ptr = value;
+		case RSVD1_REG:		atomic_store_explicit(ioreg_ptr, value, memory_order_relaxed);
 							break;
 
-		case RSVD2_REG:		*ioreg_ptr = value;
+		case RSVD2_REG:		atomic_store_explicit(ioreg_ptr, value, memory_order_relaxed);
 							break;
 
-		case RSVD3_REG:		*ioreg_ptr = value;
+		case RSVD3_REG:		atomic_store_explicit(ioreg_ptr, value, memory_order_relaxed);
 							break;
 
 		default:	if (rtn_code != NULL)	// shouldn't get here
@@ -173,24 +287,93 @@
  }
 
 
+/* iom361_convertTemp() */
+void iom361_convertTemp(const uint32_t* raw, float* out, size_t n) {
+	size_t i = 0;
+
+	// register values are at most 24 bits, so the signed int -> float conversions are exact
+#if defined(__AVX2__)
+	const __m256 scale = _mm256_set1_ps(IOM361_TEMP_SCALE);
+	const __m256 offset = _mm256_set1_ps(IOM361_TEMP_OFFSET);
+	for (; i + 8 <= n; i += 8) {
+		__m256 st = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*) &raw[i]));
+	#if defined(__FMA__)
+		_mm256_storeu_ps(&out[i], _mm256_fmadd_ps(st, scale, offset));
+	#else
+		_mm256_storeu_ps(&out[i], _mm256_add_ps(_mm256_mul_ps(st, scale), offset));
+	#endif
+	}
+#elif defined(__SSE2__)
+	const __m128 scale = _mm_set1_ps(IOM361_TEMP_SCALE);
+	const __m128 offset = _mm_set1_ps(IOM361_TEMP_OFFSET);
+	for (; i + 4 <= n; i += 4) {
+		__m128 st = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*) &raw[i]));
+		_mm_storeu_ps(&out[i], _mm_add_ps(_mm_mul_ps(st, scale), offset));
+	}
+#endif
+
+	for (; i < n; i++) {
+		out[i] = (float) raw[i] * IOM361_TEMP_SCALE + IOM361_TEMP_OFFSET;
+	}
+}
+
+/* iom361_convertHumid() */
+void iom361_convertHumid(const uint32_t* raw, float* out, size_t n) {
+	size_t i = 0;
+
+#if defined(__AVX2__)
+	const __m256 scale = _mm256_set1_ps(IOM361_HUMID_SCALE);
+	for (; i + 8 <= n; i += 8) {
+		__m256 srh = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*) &raw[i]));
+		_mm256_storeu_ps(&out[i], _mm256_mul_ps(srh, scale));
+	}
+#elif defined(__SSE2__)
+	const __m128 scale = _mm_set1_ps(IOM361_HUMID_SCALE);
+	for (; i + 4 <= n; i += 4) {
+		__m128 srh = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*) &raw[i]));
+		_mm_storeu_ps(&out[i], _mm_mul_ps(srh, scale));
+	}
+#endif
+
+	for (; i < n; i++) {
+		out[i] = (float) raw[i] * IOM361_HUMID_SCALE;
+	}
+}
+
+
 // Functions used for testing - set register values for read-only registers
 
 /* _iom361_setSwitches() */
 void _iom361_setSwitches(uint32_t value){
-	uint32_t* ioreg_ptr = IOSpacePtr + (SWITCHES_REG / sizeof(uint32_t));
-
-	// this one is straightforward - just write value to switch register
-	*ioreg_ptr = value;
-	return;
+	_iom361_devSetSwitches(&default_dev, value);
 }
 
 
 /* _iom361_setSensor1() */
 void _iom361_setSensor1(float new_temp, float new_humid){
+	_iom361_devSetSensor1(&default_dev, new_temp, new_humid);
+}
+
+
+/* _iom361_setSensor1_rndm() */
+void _iom361_setSensor1_rndm(float temp_low, float temp_hi,
+	float humid_low, float humid_hi) {
+	_iom361_devSetSensor1_rndm(&default_dev, temp_low, temp_hi, humid_low, humid_hi);
+}
+
+
+/* _iom361_devSetSwitches() */
+void _iom361_devSetSwitches(iom361_dev_t* dev, uint32_t value){
+	// this one is straightforward - just write value to switch register
+	atomic_store_explicit(&dev->regs[SWITCHES_REG / sizeof(uint32_t)], value, memory_order_relaxed);
+}
+
+
+/* _iom361_devSetSensor1() */
+void _iom361_devSetSensor1(iom361_dev_t* dev, float new_temp, float new_humid){
 	float temp_float, humid_float;
 	uint32_t temp_value, humid_value;
-
-	uint32_t* ioreg_ptr;
+	uint32_t seq;
 
 	static float temp_const = powf(2, 20) / 200.0;
 	static float rh_const = powf(2,20) / 100.0;
@@ -205,30 +388,108 @@ void _iom361_setSensor1(float new_temp, float new_humid){
 	humid_float = rh_const * new_humid;
 	humid_value = (uint32_t) humid_float;
 
+	// claim the sequence counter (make it odd) so concurrent setters take turns
+	seq = atomic_load_explicit(&dev->sensor_seq, memory_order_relaxed);
+	do {
+		while (seq & 1)
+			seq = atomic_load_explicit(&dev->sensor_seq, memory_order_relaxed);
+	} while (!atomic_compare_exchange_weak_explicit(&dev->sensor_seq, &seq, seq + 1,
+		memory_order_relaxed, memory_order_relaxed));
+	atomic_thread_fence(memory_order_release);
+
 	// write the I/O registers
-	ioreg_ptr = IOSpacePtr + (TEMP_REG / sizeof(uint32_t));
-	*ioreg_ptr = temp_value;
+	atomic_store_explicit(&dev->regs[TEMP_REG / sizeof(uint32_t)], temp_value, memory_order_relaxed);
+	atomic_store_explicit(&dev->regs[HUMID_REG / sizeof(uint32_t)], humid_value, memory_order_relaxed);
 
-	ioreg_ptr = IOSpacePtr + (HUMID_REG / sizeof(uint32_t));
-	*ioreg_ptr = humid_value;
-	return;
+	// even again: the new pair is visible to readers
+	atomic_store_explicit(&dev->sensor_seq, seq + 2, memory_order_release);
 }
 
 
-/* _iom361_setSensor1_rndm() */
-void _iom361_setSensor1_rndm(float temp_low, float temp_hi,
+/* _iom361_devSetSensor1_rndm() */
+void _iom361_devSetSensor1_rndm(iom361_dev_t* dev, float temp_low, float temp_hi,
 	float humid_low, float humid_hi) {
 	float new_temp = 0.0, new_humid = 0.0;
 
 	new_temp = (float) float_rand_in_range(temp_low, temp_hi);
 	new_humid = (float) float_rand_in_range(humid_low, humid_hi);
-	_iom361_setSensor1(new_temp, new_humid);
+	_iom361_devSetSensor1(dev, new_temp, new_humid);
 }
 
 
 
 // Helper Functions
 
+/**
+ * init_device() - puts a device's registers in their power-on state
+ *
+ * @param	dev is the device to initialize
+ * @param	num_switches is the number of switches
+ * @param	num_leds is the number of LEDs
+ *
+ */
+static void init_device(iom361_dev_t* dev, int num_switches, int num_leds) {
+	dev->nsw = num_switches;
+	dev->nleds = num_leds;
+	atomic_init(&dev->sensor_seq, 0);
+	for (int i = 0; i < NUM_IO_REGS; i++) {
+		atomic_init(&dev->regs[i], 0);
+	}
+
+	// initialize the I/O registers
+	iom361_devWriteReg(dev, LEDS_REG, 0x00000000, NULL);
+	iom361_devWriteReg(dev, RGB_LED_REG, 0x00000000, NULL);
+	iom361_devWriteReg(dev, RSVD1_REG, 0x11111111, NULL);
+	iom361_devWriteReg(dev, RSVD2_REG, 0x22222222, NULL);
+	iom361_devWriteReg(dev, RSVD3_REG, 0x33333333, NULL);
+
+	_iom361_devSetSwitches(dev, 0x00000000);
+	_iom361_devSetSensor1(dev, 23.5, 75.0);
+}
+
+
+/**
+ * device_at() - maps a base address from iom361_initialize() to its device
+ *
+ * @param	base is the base address passed to the API
+ *
+ * @return	the default device, NULL if base does not point to it
+ *
+ */
+static iom361_dev_t* device_at(uint32_t* base) {
+	if ((base == NULL) || (base != default_base))
+		return NULL;
+	return &default_dev;
+}
+
+
+/**
+ * read_sensor_pair() - reads temperature and humidity from the same Sensor 1 update
+ *
+ * Retries while a setter is in the middle of an update (sequence counter odd)
+ * or finished one during the read (counter changed).
+ *
+ * @param	dev is the device to read
+ * @param	temp receives the raw temperature register
+ * @param	humid receives the raw humidity register
+ *
+ */
+static void read_sensor_pair(iom361_dev_t* dev, uint32_t* temp, uint32_t* humid) {
+	uint32_t seq, t, h;
+
+	for (;;) {
+		seq = atomic_load_explicit(&dev->sensor_seq, memory_order_acquire);
+		t = atomic_load_explicit(&dev->regs[TEMP_REG / sizeof(uint32_t)], memory_order_relaxed);
+		h = atomic_load_explicit(&dev->regs[HUMID_REG / sizeof(uint32_t)], memory_order_relaxed);
+		atomic_thread_fence(memory_order_acquire);
+		if (((seq & 1) == 0) && (atomic_load_explicit(&dev->sensor_seq, memory_order_relaxed) == seq))
+			break;
+	}
+	*temp = t;
+	*humid = h;
+}
+
+
 /**
  * display_leds() - displays the LED register
  *
@@ -240,6 +501,8 @@ void _iom361_setSensor1_rndm(float temp_low, float temp_hi,
  */
 static void display_leds(uint32_t value, int num_leds) {
 	char leds[32];
+	char line[32 + 2 * 8 + 1];		// LEDs plus two spaces per group of four
+	int pos = 0;
 
 	// put either '0' (on) or 'x' (off) for each LED
 	for (int i = 0; i < num_leds; i++) {
@@ -247,15 +510,17 @@ static void display_leds(uint32_t value, int num_leds) {
 	}
 
 	// and put to display in reverse order
-	// break into 4 led groups
+	// break into 4 led groups.  Built as one line so devices on other
+	// threads can't interleave their output with it
 	for (int i = num_leds - 1; i >= 0; i--) {
 		if ((num_leds - 1 - i) % 4 == 0) {
-			putchar(' ');
-			putchar(' ');
+			line[pos++] = ' ';
+			line[pos++] = ' ';
 		}
-		putchar(leds[i]);
+		line[pos++] = leds[i];
 	}
-	printf("\n");
+	line[pos] = '\0';
+	printf("%s\n", line);
 	return;
 }
 
@@ -56,8 +56,10 @@
  #ifndef _IOM361_H
  #define _IOM361_H
 
+ #include <stddef.h>
  #include <stdint.h>
  #include <stdbool.h>
+ #include <stdatomic.h>
 
  // define the I/O register map
  typedef struct {
@@ -83,14 +85,50 @@
 	 RSVD3_REG		= 0x1C
  };
 
+ // one temperature/humidity sample from Sensor 1, as raw register words
+ typedef struct {
+	 uint32_t	temp;
+	 uint32_t	humid;
+ } iom361_sample_t, *iom361_sample_ptr_t;
+
+ // caller-owned ring buffer filled by iom361_captureSensor1()
+ typedef struct {
+	 iom361_sample_t*	buf;		// storage for capacity samples
+	 uint32_t			capacity;
+	 uint32_t			head;		// next slot to write
+	 uint32_t			count;		// valid samples, saturates at capacity
+ } iom361_ring_t, *iom361_ring_ptr_t;
+
  // define constants
   #define NUM_IO_REGS	8		// There are 8 IO registers in the I/O map
 
+ // one emulated I/O module.  Every board keeps its own register file, so any
+ // number of them can run side by side, each on its own thread if desired.
+ // Registers are accessed atomically; Sensor 1 updates are published under a
+ // sequence counter so temperature and humidity are always read as a pair
+ typedef struct {
+	 _Atomic uint32_t	regs[NUM_IO_REGS];
+	 _Atomic uint32_t	sensor_seq;		// odd while a Sensor 1 update is in progress
+	 int				nsw;			// number of switches
+	 int				nleds;			// number of LEDs
+ } iom361_dev_t, *iom361_dev_ptr_t;
+
+ // AHT20 conversion constants, precomputed from the formulas above
+ //	Temp(degrees C) = ST * IOM361_TEMP_SCALE + IOM361_TEMP_OFFSET
+ //	Rel Humidity(%) = SRH * IOM361_HUMID_SCALE
+  #define IOM361_TEMP_SCALE		(200.0f / 1048576.0f)
+  #define IOM361_TEMP_OFFSET	(-50.0f)
+  #define IOM361_HUMID_SCALE	(100.0f / 1048576.0f)
+
  /*
   * API functions.  These are low level functions that read/write the
   * I/O registers directly.  You can use them to build higher level
   * functionality in your own code, but it doesn't get much more basic
   * than this.
+  *
+  * The base-pointer functions all act on one default device set up by
+  * iom361_initialize().  The iom361_dev*() functions further down do the same
+  * work on a device created with iom361_create().
   */
 
  /**
@@ -125,6 +163,52 @@ uint32_t* iom361_initialize(int num_switches, int num_leds, int* rtn_code);
 uint32_t iom361_readReg(uint32_t* base, uint32_t offset, int* rtn_code);
 
 
+ /** iom361_readRegs() - reads a block of consecutive I/O registers
+  *
+  * copies count registers starting at base + offset into values with one
+  * validation of base and the whole range.  Use it to snapshot TEMP_REG and
+  * HUMID_REG together, or the entire ioreg_t with offset 0 and NUM_IO_REGS.
+  * Updates rtn_code if the function succeeds (0) or fails (> 0)
+  *
+  * @param	base: address of the base of the I/O memory block
+  * @param	offset: offset of the first register.  Must be on a register boundary
+  * @param	values: array receiving count register values
+  * @param	count: number of registers to read
+  * @param	*rtn_code: a pointer to the return code.  Will be 0 for success, a different
+  *			number if the call fails.
+  *
+  * @return the number of registers copied, 0 if the call fails
+  */
+int iom361_readRegs(uint32_t* base, uint32_t offset, uint32_t* values, int count, int* rtn_code);
+
+
+ /** iom361_readSensor1() - reads the temperature and humidity registers together
+  *
+  * @param	base: address of the base of the I/O memory block
+  * @param	sample: receives the raw temperature and humidity register values
+  * @param	*rtn_code: a pointer to the return code.  Will be 0 for success, a different
+  *			number if the call fails.
+  */
+void iom361_readSensor1(uint32_t* base, iom361_sample_t* sample, int* rtn_code);
+
+
+ /** iom361_captureSensor1() - captures consecutive Sensor 1 samples into a ring buffer
+  *
+  * validates base once and then appends n temperature/humidity samples to the
+  * caller's ring buffer, overwriting the oldest samples once it is full.
+  *
+  * @param	base: address of the base of the I/O memory block
+  * @param	ring: ring buffer to fill.  buf and capacity must be set, head must be
+  *			below capacity and count no more than capacity
+  * @param	n: number of samples to capture
+  * @param	*rtn_code: a pointer to the return code.  Will be 0 for success, a different
+  *			number if the call fails.
+  *
+  * @return the number of samples captured, 0 if the call fails
+  */
+int iom361_captureSensor1(uint32_t* base, iom361_ring_t* ring, int n, int* rtn_code);
+
+
  /**
   * iom361_writeReg() - writes a 32-bit value to an I/O register
   *
@@ -141,6 +225,130 @@ uint32_t iom361_readReg(uint32_t* base, uint32_t offset, int* rtn_code);
 uint32_t iom361_writeReg(uint32_t* base, int offset, uint32_t value, int* rtn_code);
 
 
+ /**
+  * iom361_convertTemp() - converts raw AHT20 temperature words to degrees C
+  *
+  * Converts n raw temperature register values to floats.  Uses AVX2 (8 samples
+  * per step) or SSE2 (4 samples per step) when the build enables them, with a
+  * scalar loop for the remainder.
+  *
+  * @param	raw: array of n raw temperature register values
+  * @param	out: array receiving n temperatures in degrees C
+  * @param	n: number of samples
+  */
+void iom361_convertTemp(const uint32_t* raw, float* out, size_t n);
+
+
+ /**
+  * iom361_convertHumid() - converts raw AHT20 humidity words to % relative humidity
+  *
+  * Same as iom361_convertTemp() for the humidity register.
+  *
+  * @param	raw: array of n raw humidity register values
+  * @param	out: array receiving n humidities in %
+  * @param	n: number of samples
+  */
+void iom361_convertHumid(const uint32_t* raw, float* out, size_t n);
+
+
+ /*
+  * Per-device API.  Same register semantics and return codes as the functions
+  * above, but on a device handle instead of the default device.  Distinct
+  * devices share no state; one device may be read and written from several
+  * threads at once.
+  */
+
+ /**
+  * iom361_create() - creates and initializes an emulated I/O module
+  *
+  * @param	num_switches: the number of switches (up to 32) in the device
+  * @param	num_leds: the number of leds (up to 32) in the device
+  * @param	*rtn_code: a pointer to the return code.  Will be 0 for success, a different
+  *			number if the call fails.
+  *
+  * @return	the new device, NULL if the function fails
+  */
+iom361_dev_t* iom361_create(int num_switches, int num_leds, int* rtn_code);
+
+
+ /**
+  * iom361_destroy() - frees a device made by iom361_create()
+  *
+  * @param	dev: the device to free.  NULL is ignored
+  */
+void iom361_destroy(iom361_dev_t* dev);
+
+
+ /**
+  * iom361_devReadReg() - returns the value of an I/O register
+  *
+  * @param	dev: the device to read
+  * @param	offset: offset into the register block.  All registers are 32-bits wide
+  * @param	*rtn_code: a pointer to the return code.  Will be 0 for success, a different
+  *			number if the call fails.
+  *
+  * @return the contents of the specified I/O register
+  */
+uint32_t iom361_devReadReg(iom361_dev_t* dev, uint32_t offset, int* rtn_code);
+
+
+ /**
+  * iom361_devReadRegs() - reads a block of consecutive I/O registers
+  *
+  * @param	dev: the device to read
+  * @param	offset: offset of the first register.  Must be on a register boundary
+  * @param	values: array receiving count register values
+  * @param	count: number of registers to read
+  * @param	*rtn_code: a pointer to the return code.  Will be 0 for success, a different
+  *			number if the call fails.
+  *
+  * @return the number of registers copied, 0 if the call fails
+  */
+int iom361_devReadRegs(iom361_dev_t* dev, uint32_t offset, uint32_t* values, int count, int* rtn_code);
+
+
+ /**
+  * iom361_devReadSensor1() - reads the temperature and humidity registers together
+  *
+  * Both values always come from the same Sensor 1 update.
+  *
+  * @param	dev: the device to read
+  * @param	sample: receives the raw temperature and humidity register values
+  * @param	*rtn_code: a pointer to the return code.  Will be 0 for success, a different
+  *			number if the call fails.
+  */
+void iom361_devReadSensor1(iom361_dev_t* dev, iom361_sample_t* sample, int* rtn_code);
+
+
+ /**
+  * iom361_devCaptureSensor1() - captures consecutive Sensor 1 samples into a ring buffer
+  *
+  * @param	dev: the device to read
+  * @param	ring: ring buffer to fill.  buf and capacity must be set, head must be
+  *			below capacity and count no more than capacity
+  * @param	n: number of samples to capture
+  * @param	*rtn_code: a pointer to the return code.  Will be 0 for success, a different
+  *			number if the call fails.
+  *
+  * @return the number of samples captured, 0 if the call fails
+  */
+int iom361_devCaptureSensor1(iom361_dev_t* dev, iom361_ring_t* ring, int n, int* rtn_code);
+
+
+ /**
+  * iom361_devWriteReg() - writes a 32-bit value to an I/O register
+  *
+  * @param	dev: the device to write
+  * @param	offset: offset into the register block.  All registers are 32-bits wide
+  * @param	value: new register value
+  * @param	*rtn_code: a pointer to the return code.  Will be 0 for success, a different
+  *			number if the call fails.
+  *
+  * @return the value written
+  */
+uint32_t iom361_devWriteReg(iom361_dev_t* dev, int offset, uint32_t value, int* rtn_code);
+
+
 /* These functions are used for testing.  They set a specific register to a value.  For
  * example, there is a function to write a new value to the switch register.  The same
  * for the temp/humidity sensor.  I added these functions because we are emulating
@@ -194,10 +402,43 @@ void _iom361_setSensor1(float new_temp, float new_humid);
   * @param	humid_hi: high relative humidity in range   Specified as float.
   *			conversion to a register value is done in the function
   *
-  * @note	Uses srand(time(NULL) to initialize rand().  This is done when
-  *			iom361 is initialized.
+  * @note	Draws from the calling thread's generator in float_rndm.  Call
+  *			float_rand_seed() first for a reproducible sequence.
   */
 void _iom361_setSensor1_rndm(float temp_low, float temp_hi,
 	float humid_low, float humid_hi);
 
+ /**
+  * _iom361_devSetSwitches() - sets the value of a device's switch register
+  *
+  * @param	dev: the device to update
+  * @param	value: value for the switch register
+  */
+void _iom361_devSetSwitches(iom361_dev_t* dev, uint32_t value);
+
+
+ /**
+  * _iom361_devSetSensor1() - sets the temperature and humidity for a device's Sensor 1
+  *
+  * Readers see either the old pair or the new one, never a mix.
+  *
+  * @param	dev: the device to update
+  * @param	new_temp: new temperature value in degrees C
+  * @param	new_humid: new relative humidity value in %
+  */
+void _iom361_devSetSensor1(iom361_dev_t* dev, float new_temp, float new_humid);
+
+
+ /**
+  * _iom361_devSetSensor1_rndm() - sets a device's Sensor 1 to random values in range
+  *
+  * @param	dev: the device to update
+  * @param	temp_low: low temperature for range in degrees C
+  * @param	temp_hi: high temperature for range in degrees C
+  * @param	humid_low: low relative humidity in range
+  * @param	humid_hi: high relative humidity in range
+  */
+void _iom361_devSetSensor1_rndm(iom361_dev_t* dev, float temp_low, float temp_hi,
+	float humid_low, float humid_hi);
+
 #endif
@@ -13,13 +13,21 @@
 
 #include <stdlib.h>
 #include <stdio.h>
-#include <math.h>
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
 #include <time.h>
+#include <pthread.h>
+#include <sched.h>
 #include "bst.h"
+#include "bst_frozen.h"
+#include "bst_print.h"
+#include "bst_snapshot.h"
+#include "float_rndm.h"
+#include "ingest.h"
 #include "iom361_r2.h"
+#include "spsc_ring.h"
+#include "wal.h"
 
 // typedefs, enums and constants
 #define TEMP_RANGE_LOW  42.0
@@ -32,12 +40,67 @@ uint32_t* io_base;
 
 #define MAX_CHAR 1000 // Arbitrary big number for buffer
 
+#define NUM_DAYS        30      // days of November to simulate
+#define RING_CAPACITY   64      // readings in flight between acquisition and ingest
+#define ACQ_BURST       8       // samples read and converted together by the acquisition thread
+#define INGEST_BATCH    16      // readings drained from the ring per ingest step
+#define WAL_SYNC_EVERY  65536   // readings per group commit of the write-ahead log
+
+// Arguments for the acquisition thread
+typedef struct {
+    uint32_t* io_base;
+    spsc_ring_ptr_t ring;
+} acquisition_args_t;
+
+// Where new readings go: the write-ahead log first when one is open, then the tree
+typedef struct {
+    bst_node_ptr_t* tree;
+    bst_arena_ptr_t arena;
+    wal_ptr_t wal;
+    int failed;         // set when the log could not be written or a node allocated
+} reading_store_t;
+
 // Prototype functions
-void populateBST();
+static int store_readings(const temp_humid_data_t* batch, size_t n, void* ctx);
+static int simulate_readings(reading_store_t* store);
+static int load_readings(const char* path, ingest_format_t format, reading_store_t* store);
+static int write_snapshot(const char* path, bst_node_ptr_t tree, bst_snapshot_ptr_t snapshot);
+static void* acquire_readings(void* arg);
 
-int main(void) {
-    int rtn_code;
-    float temp, humid;
+int main(int argc, char* argv[]) {
+    const char* log_path = NULL;
+    const char* snapshot_in = NULL;
+    const char* snapshot_out = NULL;
+    const char* wal_path = NULL;
+    ingest_format_t log_format = INGEST_CSV;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-f") == 0 && i + 1 < argc) {
+            log_path = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0) {
+            log_format = INGEST_BINARY;
+        } else if (strcmp(argv[i], "-l") == 0 && i + 1 < argc) {
+            snapshot_in = argv[++i];
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            snapshot_out = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc) {
+            wal_path = argv[++i];
+        } else {
+            fprintf(stderr, "Usage: %s [-f log_file|-] [-b] [-l snapshot] [-s snapshot] [-w wal]\n", argv[0]);
+            fprintf(stderr, "  -f  load readings from a CSV log (timestamp,temp,humid per line), - for stdin\n");
+            fprintf(stderr, "  -b  the log holds binary records instead of CSV\n");
+            fprintf(stderr, "  -l  query a snapshot saved by -s instead of building a tree\n");
+            fprintf(stderr, "  -s  save the readings to a snapshot file\n");
+            fprintf(stderr, "  -w  replay a write-ahead log into the tree, then log every new reading to it\n");
+            fprintf(stderr, "      (without -f, the simulation only runs while the log is empty)\n");
+            fprintf(stderr, "Without -f or -l, readings for November 2024 are simulated.\n");
+            return 1;
+        }
+    }
+    if (snapshot_in != NULL && wal_path != NULL) {
+        fprintf(stderr, "FATAL(main): -l queries a read-only snapshot and cannot take new readings from -w\n");
+        return 1;
+    }
 
     // Boilerplate greeting
     printf("ECE 361 - HW 5 - BST and Humidity and Temp Sensors - @author: Crow Crossman (crowc@pdx.edu)\n");
@@ -54,67 +117,68 @@ int main(void) {
     }
     printf("\n");
 
-    // Initialize imo361
-    printf("Launching imo361 system...\t");
-    io_base = iom361_initialize(0, 0, &rtn_code);
-    if (rtn_code != 0) {
-        // initialization failed
-        printf("FATAL(main): Could not initialize I/O module\n");
+    bst_arena_ptr_t arena = create_arena(0);
+    if (arena == NULL) {
+        printf("FATAL(main): Could not allocate the tree arena\n");
         return 1;
     }
-    printf("Success!\n");
-
-    // Create a month of temp/humidity/timestamp values
-    uint32_t temp_value, humid_value;
-    float temp_arr[30];
-    float humid_arr[30];
-    time_t timestamp_arr[30];
-    temp_humid_data_t data[30];
 
-    // Since these are made up dates, the goal is to take the temp/humidity values for 30 days of November
-    printf("Generating simulated temp and humidity readings for November...\t");
-    for (int i = 0; i < 30; i++) {
-        _iom361_setSensor1_rndm(TEMP_RANGE_LOW, TEMP_RANGE_HI, HUMID_RANGE_LOW,
-        HUMID_RANGE_HI);
-        temp_value = iom361_readReg(io_base, TEMP_REG, NULL);
-        temp = (temp_value / powf(2,20)) * 200.0 - 50;
-        humid_value = iom361_readReg(io_base, HUMID_REG, NULL);
-        humid = (humid_value/ pow(2, 20)) * 100;
-
-        temp_arr[i] = temp;
-        humid_arr[i] = humid;
-        timestamp_arr[i] = con_to_ut(11, i + 1, 2024);
-
-        data[i].timestamp = timestamp_arr[i];
-        data[i].temp = temp_arr[i];
-        data[i].humid = humid_arr[i];
-    }
-    printf("Success!\n");
+    // Tree is self-balancing, so readings can go in arrival (sorted) order without a shuffle
+    bst_node_ptr_t tree = NULL;
+    bst_snapshot_ptr_t snapshot = NULL;
+    if (snapshot_in != NULL) {
+        // Mapped, not loaded: ready at once however many readings it holds
+        snapshot = open_snapshot(snapshot_in);
+        if (snapshot == NULL) {
+            printf("FATAL(main): Could not open snapshot %s\n", snapshot_in);
+            return 1;
+        }
+        printf("Opened snapshot %s (%zu readings)\n\n", snapshot_in, snapshot->frozen.size);
+    } else {
+        reading_store_t store = {&tree, arena, NULL, 0};
+        size_t recovered = 0;
+        if (wal_path != NULL) {
+            // Readings from earlier runs come back first, then new ones are logged before they go in
+            wal_replay_stats_t replayed;
+            if (wal_replay(wal_path, &tree, arena, &replayed) != 0
+                || (store.wal = wal_open(wal_path, WAL_SYNC_EVERY)) == NULL) {
+                printf("FATAL(main): Could not recover write-ahead log %s\n", wal_path);
+                return 1;
+            }
+            recovered = replayed.readings;
+            printf("Replayed %zu readings from %s", replayed.readings, wal_path);
+            if (replayed.truncated > 0) {
+                printf(" (dropped %llu bytes of incomplete tail)", (unsigned long long)replayed.truncated);
+            }
+            printf("\n");
+        }
 
-    printf("Shuffling values...\t");
-    // Shuffle shuffle shuffle
-    srand(time(NULL));
-    temp_humid_data_t shuffled_deck[30];
-    int banlist[30] = {0};
-    // Pick a number between 1 and 30, place item 1 there, now randomly pick next number, etc...
-    int random_pick = 0;
-    for (int i = 0; i < 30; i++) {
-        int r = (rand() % 30);
-        // Check if r has been used already
-        while (banlist[r] == 1) {
-            r = (rand() % 30);
+        // The simulated month is the same every run, so a log holding readings already has it
+        int rtn_code = 0;
+        if (log_path != NULL) {
+            rtn_code = load_readings(log_path, log_format, &store);
+        } else if (recovered == 0) {
+            rtn_code = simulate_readings(&store);
+        } else {
+            printf("Skipping the simulation, its readings came back from the write-ahead log\n\n");
+        }
+        if (wal_close(store.wal) != 0 || store.failed) {
+            if (wal_path != NULL) {
+                printf("FATAL(main): Could not store readings in the tree and write-ahead log %s\n", wal_path);
+            } else {
+                printf("FATAL(main): Could not store readings in the tree\n");
+            }
+            return 1;
+        }
+        if (rtn_code != 0) {
+            return 1;
         }
-        shuffled_deck[r] = data[i];
-        //printf("Position %d in deck got shuffled to position %d\n", i, r);
-        banlist[r] = 1;
     }
-    printf("Success!\n");
 
-    printf("Growing a tree...\t");
-    // Create our tree with shuffled order
-    int size = sizeof(data) / sizeof(data[0]);
-    bst_node_ptr_t tree = create_tree(shuffled_deck, size);
-    printf("Success!\n\n");
+    if (snapshot_out != NULL && write_snapshot(snapshot_out, tree, snapshot) != 0) {
+        printf("FATAL(main): Could not save snapshot %s\n", snapshot_out);
+        return 1;
+    }
 
     // Our main loop to get input
     char buffer[MAX_CHAR];
@@ -122,7 +186,10 @@ int main(void) {
 
     printf("Please enter a date to search in format: MM/DD/YYYY\n");
     while (i < MAX_CHAR - 1) {
-        char c = getchar();
+        int c = getchar();
+        if (c == EOF) {
+            break;
+        }
         if (c == '\n') {
             if (i == 0) {
                 break;
@@ -132,7 +199,11 @@ int main(void) {
             int m, d, y;
             if (sscanf(buffer, "%d/%d/%d", &m, &d, &y) == 3) {   // Cool format handling found on stackoverflow (https://stackoverflow.com/questions/1412513/getting-multiple-values-with-scanf)
                 printf("Searching for timestamp...\n");
-                search_tree(tree,con_to_ut(m, d, y));
+                if (snapshot != NULL) {
+                    print_reading_result(search_frozen(&snapshot->frozen, con_to_ut(m, d, y)));
+                } else {
+                    print_search_result(search_tree(tree, con_to_ut(m, d, y)));
+                }
             } else {
                 printf("Invalid format.\n");
             }
@@ -146,7 +217,223 @@ int main(void) {
 
     // Print in-order traversal
     printf("In-order traversal:\n\n");
-    traverse_in_order(tree);
+    if (snapshot != NULL) {
+        traverse_frozen(&snapshot->frozen, print_reading, stdout);
+    } else {
+        print_tree_in_order(tree);
+    }
+
+    // Every node lives in the arena, so releasing it frees the whole tree
+    close_snapshot(snapshot);
+    destroy_arena(arena);
+    return 0;
+}
+
+
+/**
+ * store_readings() - logs and inserts a batch of new readings
+ *
+ * An ingest_sink_t.  With a write-ahead log open, the batch is appended to it
+ * before the tree sees it.
+ *
+ * @param	batch: readings to store
+ * @param	n: number of readings
+ * @param	ctx: the reading_store_t
+ * @return	0 to keep going, 1 if the log could not be written or a node allocated
+ */
+static int store_readings(const temp_humid_data_t* batch, size_t n, void* ctx) {
+    reading_store_t* store = (reading_store_t*)ctx;
+
+    if (store->failed) {
+        return 1;
+    }
+    if (store->wal != NULL && wal_append(store->wal, batch, n) != 0) {
+        store->failed = 1;
+        return 1;
+    }
+    for (size_t k = 0; k < n; k++) {
+        if (insert_node_policy(store->tree, batch[k], store->arena, BST_DUP_CHAIN) < 0) {
+            store->failed = 1;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * simulate_readings() - grows the tree from emulated Sensor 1 readings
+ *
+ * Acquisition runs on its own thread and hands readings to this one through a
+ * lock-free ring, so sampling never waits on tree maintenance.
+ *
+ * @param	store: where the readings go
+ * @return	0 on success, 1 on a fatal error
+ */
+static int simulate_readings(reading_store_t* store) {
+    int rtn_code;
+
+    // Initialize imo361
+    printf("Launching imo361 system...\t");
+    io_base = iom361_initialize(0, 0, &rtn_code);
+    if (rtn_code != 0) {
+        // initialization failed
+        printf("FATAL(main): Could not initialize I/O module\n");
+        return 1;
+    }
+    printf("Success!\n");
+
+    spsc_ring_ptr_t ring = create_spsc_ring(RING_CAPACITY);
+    if (ring == NULL) {
+        printf("FATAL(main): Could not allocate the ingest pipeline\n");
+        return 1;
+    }
+    acquisition_args_t acq_args = {io_base, ring};
+    pthread_t acq_thread;
+
+    // Since these are made up dates, the goal is to take the temp/humidity values for 30 days of November
+    printf("Generating simulated temp and humidity readings for November and growing a tree...\t");
+    if (pthread_create(&acq_thread, NULL, acquire_readings, &acq_args) != 0) {
+        printf("FATAL(main): Could not start the acquisition thread\n");
+        destroy_spsc_ring(ring);
+        return 1;
+    }
+
+    temp_humid_data_t batch[INGEST_BATCH];
+    for (;;) {
+        size_t got = spsc_pop(ring, batch, INGEST_BATCH);
+        if (got > 0) {
+            store_readings(batch, got, store);
+        } else {
+            if (spsc_drained(ring)) break;
+            sched_yield();
+        }
+    }
+    pthread_join(acq_thread, NULL);
+    destroy_spsc_ring(ring);
+    if (store->failed) {
+        return 1;
+    }
+    printf("Success! (height %d)\n\n", tree_height(*store->tree));
+    return 0;
+}
+
+
+/**
+ * load_readings() - grows the tree from a log file, or stdin for "-"
+ *
+ * The log is streamed in chunks, so only the tree itself grows with its size.
+ *
+ * @param	path: log to read, "-" for stdin
+ * @param	format: INGEST_CSV or INGEST_BINARY
+ * @param	store: where the readings go
+ * @return	0 on success, 1 on a fatal error
+ */
+static int load_readings(const char* path, ingest_format_t format, reading_store_t* store) {
+    FILE* in = (strcmp(path, "-") == 0) ? stdin : fopen(path, "rb");
+    if (in == NULL) {
+        perror(path);
+        printf("FATAL(main): Could not open the reading log\n");
+        return 1;
+    }
 
+    printf("Loading readings from %s...\t", (in == stdin) ? "stdin" : path);
+    ingest_stats_t stats;
+    int rtn_code = ingest_stream(in, format, store_readings, store, &stats);
+    if (in != stdin) {
+        fclose(in);
+    }
+    if (rtn_code != 0) {
+        printf("FATAL(main): Could not read the reading log\n");
+        return 1;
+    }
+    if (store->failed) {
+        return 1;
+    }
+    printf("Success! (%zu readings, %zu lines skipped, height %d)\n\n", stats.readings, stats.skipped, tree_height(*store->tree));
     return 0;
 }
+
+
+/**
+ * write_snapshot() - saves the readings to a snapshot file
+ *
+ * @param	path: snapshot file to write
+ * @param	tree: tree to save when no snapshot is open
+ * @param	snapshot: open snapshot to copy, or NULL
+ * @return	0 on success, -1 on failure
+ */
+static int write_snapshot(const char* path, bst_node_ptr_t tree, bst_snapshot_ptr_t snapshot) {
+    if (snapshot != NULL) {
+        return save_snapshot(&snapshot->frozen, path);
+    }
+
+    bst_frozen_ptr_t frozen = freeze_tree(tree);
+    if (frozen == NULL) {
+        return -1;
+    }
+    int rtn_code = save_snapshot(frozen, path);
+    if (rtn_code == 0) {
+        printf("Saved %zu readings to snapshot %s\n\n", frozen->size, path);
+    }
+    destroy_frozen(frozen);
+    return rtn_code;
+}
+
+
+/**
+ * acquire_readings() - acquisition thread
+ *
+ * Samples Sensor 1 once per simulated day of November 2024, converts the raw
+ * words in bursts of ACQ_BURST and pushes the readings into the ring.  Closes
+ * the ring when done.
+ *
+ * @param	arg: pointer to an acquisition_args_t
+ * @return	NULL
+ */
+static void* acquire_readings(void* arg) {
+    acquisition_args_t* args = (acquisition_args_t*)arg;
+    uint32_t temp_raw[ACQ_BURST];
+    uint32_t humid_raw[ACQ_BURST];
+    float temp_arr[ACQ_BURST];
+    float humid_arr[ACQ_BURST];
+    temp_humid_data_t data[ACQ_BURST];
+
+    // Different readings on every run, like the emulator's old srand(time(NULL))
+    float_rand_seed((uint64_t)time(NULL));
+
+    for (int day = 0; day < NUM_DAYS; day += ACQ_BURST) {
+        int burst = (NUM_DAYS - day < ACQ_BURST) ? NUM_DAYS - day : ACQ_BURST;
+
+        for (int i = 0; i < burst; i++) {
+            _iom361_setSensor1_rndm(TEMP_RANGE_LOW, TEMP_RANGE_HI, HUMID_RANGE_LOW,
+            HUMID_RANGE_HI);
+            iom361_sample_t sample;
+            iom361_readSensor1(args->io_base, &sample, NULL);
+            temp_raw[i] = sample.temp;
+            humid_raw[i] = sample.humid;
+        }
+
+        // Convert the raw register words in one batch
+        iom361_convertTemp(temp_raw, temp_arr, burst);
+        iom361_convertHumid(humid_raw, humid_arr, burst);
+
+        for (int i = 0; i < burst; i++) {
+            data[i].timestamp = con_to_ut(11, day + i + 1, 2024);
+            data[i].temp = temp_arr[i];
+            data[i].humid = humid_arr[i];
+        }
+
+        // Ring full means ingest is behind, give it the core
+        size_t pushed = 0;
+        while (pushed < (size_t)burst) {
+            pushed += spsc_push(args->ring, &data[pushed], burst - pushed);
+            if (pushed < (size_t)burst) {
+                sched_yield();
+            }
+        }
+    }
+
+    spsc_close(args->ring);
+    return NULL;
+}
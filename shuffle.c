@@ -0,0 +1,97 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "shuffle.h"
+#include "float_rndm.h"
+
+#ifdef __GNUC__
+#define SHUFFLE_PREFETCH(addr) __builtin_prefetch((addr), 1)
+#else
+#define SHUFFLE_PREFETCH(addr) ((void)(addr))
+#endif
+
+// Lemire's multiply-shift: the high half of x * bound is uniform once the few
+// low-half values that would over-represent some results are rejected, and the
+// division needed to find them is skipped in almost every call
+uint64_t rand_bounded(uint64_t bound) {
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 m = (unsigned __int128)float_rand_u64() * bound;
+    uint64_t low = (uint64_t)m;
+    if (low < bound) {
+        uint64_t threshold = -bound % bound;
+        while (low < threshold) {
+            m = (unsigned __int128)float_rand_u64() * bound;
+            low = (uint64_t)m;
+        }
+    }
+    return (uint64_t)(m >> 64);
+#else
+    uint64_t threshold = -bound % bound;
+    uint64_t x;
+    do {
+        x = float_rand_u64();
+    } while (x < threshold);
+    return x % bound;
+#endif
+}
+
+// Targets for the next SHUFFLE_AHEAD positions are drawn early so the reading
+// each swap touches is already on its way into cache
+void shuffle_readings(temp_humid_data_t* data, size_t n) {
+    size_t ahead[SHUFFLE_AHEAD];
+    size_t i;
+
+    if (n < 2) {
+        return;
+    }
+    for (i = 0; i < SHUFFLE_AHEAD && i < n - 1; i++) {
+        ahead[i] = rand_bounded(n - i);
+        SHUFFLE_PREFETCH(&data[ahead[i]]);
+    }
+    for (i = n - 1; i > 0; i--) {
+        size_t slot = (n - 1 - i) % SHUFFLE_AHEAD;
+        size_t j = ahead[slot];
+        if (i > SHUFFLE_AHEAD) {
+            ahead[slot] = rand_bounded(i - SHUFFLE_AHEAD + 1);
+            SHUFFLE_PREFETCH(&data[ahead[slot]]);
+        }
+        temp_humid_data_t tmp = data[i];
+        data[i] = data[j];
+        data[j] = tmp;
+    }
+}
+
+void shuffle_array(void* base, size_t n, size_t size) {
+    unsigned char* bytes = (unsigned char*)base;
+
+    for (size_t i = n; i > 1; i--) {
+        size_t j = rand_bounded(i);
+        if (j == i - 1) {
+            continue;
+        }
+        unsigned char* a = bytes + (i - 1) * size;
+        unsigned char* b = bytes + j * size;
+        for (size_t k = 0; k < size; k++) {
+            unsigned char tmp = a[k];
+            a[k] = b[k];
+            b[k] = tmp;
+        }
+    }
+}
+
+// Inside-out Fisher–Yates: fills and shuffles in the same pass
+size_t* random_permutation(size_t n) {
+    size_t* perm = (size_t*)malloc((n > 0 ? n : 1) * sizeof(size_t));
+    if (perm == NULL) {
+        printf("Error! Failed to allocate memory for function[random_permutation].\n");
+        return NULL;
+    }
+    for (size_t i = 0; i < n; i++) {
+        size_t j = rand_bounded(i + 1);
+        if (j != i) {
+            perm[i] = perm[j];      // when j == i, perm[i] is not written yet
+        }
+        perm[j] = i;
+    }
+    return perm;
+}
@@ -0,0 +1,58 @@
+/**
+* shuffle.h - Header file for random shuffles and permutations
+ *
+ * @file:               shuffle.h
+ * @author:            	Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Fisher–Yates shuffles in linear time for any number of elements.  Swap positions
+ * come from rand_bounded(), which is exactly uniform (no modulo bias) and draws
+ * from the calling thread's float_rndm generator, so float_rand_seed() makes a
+ * shuffle reproducible.
+ *
+ */
+
+#ifndef _SHUFFLE_H
+#define _SHUFFLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bst.h"
+
+#define SHUFFLE_AHEAD 8     // swap targets drawn (and prefetched) ahead of the swap
+
+/**
+ * @brief Returns a uniformly distributed integer in [0, bound).
+ *
+ * @param bound Exclusive upper limit.  Must be at least 1.
+ * @return The random integer.
+ */
+uint64_t rand_bounded(uint64_t bound);
+
+/**
+ * @brief Puts the readings in uniformly random order.
+ *
+ * @param data Array of readings, shuffled in place.
+ * @param n Number of readings.
+ */
+void shuffle_readings(temp_humid_data_t* data, size_t n);
+
+/**
+ * @brief Puts any array in uniformly random order.
+ *
+ * @param base First element of the array, shuffled in place.
+ * @param n Number of elements.
+ * @param size Size of one element in bytes.
+ */
+void shuffle_array(void* base, size_t n, size_t size);
+
+/**
+ * @brief Builds a uniformly random permutation of 0 .. n-1.
+ *
+ * @param n Number of elements.
+ * @return New array of n indices, freed by the caller, or NULL on failure.
+ */
+size_t* random_permutation(size_t n);
+
+#endif
@@ -0,0 +1,82 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "spsc_ring.h"
+
+spsc_ring_ptr_t create_spsc_ring(size_t capacity) {
+    size_t size = 1;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    spsc_ring_ptr_t ring = (spsc_ring_ptr_t)aligned_alloc(SPSC_CACHE_LINE,
+        (sizeof(spsc_ring_t) + SPSC_CACHE_LINE - 1) / SPSC_CACHE_LINE * SPSC_CACHE_LINE);
+    if (ring == NULL) {
+        printf("Error! Failed to allocate memory for function[create_spsc_ring].\n");
+        return NULL;
+    }
+    ring->buf = (temp_humid_data_t*)malloc(size * sizeof(temp_humid_data_t));
+    if (ring->buf == NULL) {
+        printf("Error! Failed to allocate memory for function[create_spsc_ring].\n");
+        free(ring);
+        return NULL;
+    }
+    ring->mask = size - 1;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->closed, false);
+    ring->cached_tail = 0;
+    ring->cached_head = 0;
+    return ring;
+}
+
+void destroy_spsc_ring(spsc_ring_ptr_t ring) {
+    if (ring == NULL) return;
+
+    free(ring->buf);
+    free(ring);
+}
+
+size_t spsc_push(spsc_ring_ptr_t ring, const temp_humid_data_t* items, size_t n) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t capacity = ring->mask + 1;
+
+    // Only re-read the consumer's index when the cached one says we're out of room
+    if (capacity - (head - ring->cached_tail) < n) {
+        ring->cached_tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    }
+    size_t room = capacity - (head - ring->cached_tail);
+    if (n > room) n = room;
+
+    for (size_t i = 0; i < n; i++) {
+        ring->buf[(head + i) & ring->mask] = items[i];
+    }
+    atomic_store_explicit(&ring->head, head + n, memory_order_release);
+    return n;
+}
+
+size_t spsc_pop(spsc_ring_ptr_t ring, temp_humid_data_t* out, size_t max) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    if (ring->cached_head - tail < max) {
+        ring->cached_head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    }
+    size_t avail = ring->cached_head - tail;
+    if (max > avail) max = avail;
+
+    for (size_t i = 0; i < max; i++) {
+        out[i] = ring->buf[(tail + i) & ring->mask];
+    }
+    atomic_store_explicit(&ring->tail, tail + max, memory_order_release);
+    return max;
+}
+
+void spsc_close(spsc_ring_ptr_t ring) {
+    atomic_store_explicit(&ring->closed, true, memory_order_release);
+}
+
+bool spsc_drained(spsc_ring_ptr_t ring) {
+    // closed is published after the last push, so check it before looking at head
+    if (!atomic_load_explicit(&ring->closed, memory_order_acquire)) return false;
+    return atomic_load_explicit(&ring->head, memory_order_acquire)
+        == atomic_load_explicit(&ring->tail, memory_order_relaxed);
+}
@@ -0,0 +1,90 @@
+/**
+* spsc_ring.h - Header file for the lock-free single-producer/single-consumer reading ring
+ *
+ * @file:               spsc_ring.h
+ * @author:            	Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Bounded ring of temp_humid_data_t between exactly one producer thread (sensor
+ * acquisition) and one consumer thread (tree ingest).  Push and pop never block or
+ * lock; each side only publishes its own index with release/acquire atomics and keeps
+ * a cached copy of the other side's index so the shared cache lines are touched once
+ * per batch rather than once per reading.
+ *
+ */
+
+#ifndef _SPSC_RING_H
+#define _SPSC_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "bst.h"
+
+#define SPSC_CACHE_LINE 64
+
+// Ring state.  Producer and consumer fields sit on separate cache lines.
+typedef struct spsc_ring {
+    temp_humid_data_t *buf;
+    size_t mask;                                    // capacity - 1, capacity is a power of two
+
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t head;   // next slot to write, written by the producer
+    size_t cached_tail;                             // producer's last view of tail
+    atomic_bool closed;                             // set by the producer when it is done
+
+    _Alignas(SPSC_CACHE_LINE) atomic_size_t tail;   // next slot to read, written by the consumer
+    size_t cached_head;                             // consumer's last view of head
+} spsc_ring_t, *spsc_ring_ptr_t;
+
+/**
+ * @brief Creates an empty ring.
+ *
+ * @param capacity Minimum number of readings the ring holds, rounded up to a power of two.
+ * @return spsc_ring_ptr_t Pointer to the ring, or NULL if allocation fails.
+ */
+spsc_ring_ptr_t create_spsc_ring(size_t capacity);
+
+/**
+ * @brief Frees a ring.  Neither thread may be using it any more.
+ *
+ * @param ring Pointer to the ring (NULL is ignored).
+ */
+void destroy_spsc_ring(spsc_ring_ptr_t ring);
+
+/**
+ * @brief Producer side: appends up to n readings without blocking.
+ *
+ * @param ring Pointer to the ring.
+ * @param items Readings to append.
+ * @param n Number of readings.
+ * @return size_t Number of readings appended, less than n if the ring filled up.
+ */
+size_t spsc_push(spsc_ring_ptr_t ring, const temp_humid_data_t* items, size_t n);
+
+/**
+ * @brief Consumer side: removes up to max readings without blocking.
+ *
+ * @param ring Pointer to the ring.
+ * @param out Buffer receiving the readings, oldest first.
+ * @param max Capacity of the buffer.
+ * @return size_t Number of readings removed, 0 if the ring was empty.
+ */
+size_t spsc_pop(spsc_ring_ptr_t ring, temp_humid_data_t* out, size_t max);
+
+/**
+ * @brief Producer side: marks the stream as finished.  Readings already pushed can still be popped.
+ *
+ * @param ring Pointer to the ring.
+ */
+void spsc_close(spsc_ring_ptr_t ring);
+
+/**
+ * @brief Consumer side: true once the producer has closed the ring and every reading was popped.
+ *
+ * @param ring Pointer to the ring.
+ * @return bool True if no more readings will ever arrive.
+ */
+bool spsc_drained(spsc_ring_ptr_t ring);
+
+#endif
@@ -0,0 +1,79 @@
+/**
+ * test_bst_avl.c - AVL balance of the timestamp tree
+ *
+ * @file:               test_bst_avl.c
+ * @author:             Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Inserts readings in ascending, descending and scrambled order and checks that
+ * every node's stored height is right, every balance factor is within one, the
+ * tree height stays inside the AVL bound and an in-order walk returns every
+ * reading sorted.  Exits non-zero on failure.
+ *
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include "bst.h"
+#include "test_util.h"
+
+#define NUM_KEYS    4096    // a power of two, so the scrambled order is a permutation
+
+// Height of the subtree, or -1 if a stored height or balance factor is wrong
+static int verify(bst_node_ptr_t node) {
+    if (node == NULL) return 0;
+    int left = verify(node->left);
+    int right = verify(node->right);
+    if (left < 0 || right < 0) return -1;
+    int height = 1 + ((left > right) ? left : right);
+    if (node->height != height || left - right > 1 || right - left > 1) return -1;
+    return height;
+}
+
+static void walk(bst_node_ptr_t node, test_order_t* order) {
+    if (node == NULL) return;
+    walk(node->left, order);
+    test_check_order(&node->data, order);
+    walk(node->right, order);
+}
+
+static void free_nodes(bst_node_ptr_t node) {
+    if (node == NULL) return;
+    free_nodes(node->left);
+    free_nodes(node->right);
+    free(node);
+}
+
+static time_t key_at(int order, int i) {
+    switch (order) {
+    case 0:  return i;
+    case 1:  return NUM_KEYS - 1 - i;
+    default: return (time_t)(((uint64_t)i * 2654435761u) % NUM_KEYS);
+    }
+}
+
+int main(void) {
+    const char* names[] = {"ascending", "descending", "scrambled"};
+    int failures = 0;
+
+    for (int order = 0; order < 3; order++) {
+        bst_node_ptr_t tree = NULL;
+        for (int i = 0; i < NUM_KEYS; i++) {
+            temp_humid_data_t data = {key_at(order, i), (uint32_t)i, (uint32_t)i};
+            insert_node(&tree, data);
+        }
+
+        int height = verify(tree);
+        failures += test_check(height > 0, "stored heights and balance factors (%s)", names[order]);
+        failures += test_check(height == tree_height(tree), "tree_height (%s)", names[order]);
+        failures += test_check(height <= (int)(1.4405 * log2(NUM_KEYS + 2.0)), "AVL height bound (%s)", names[order]);
+
+        test_order_t walked = TEST_ORDER_INIT;
+        walk(tree, &walked);
+        failures += test_check(walked.count == NUM_KEYS && walked.ordered, "in-order walk (%s)", names[order]);
+        failures += test_check(search_tree(tree, NUM_KEYS / 3) != NULL, "search (%s)", names[order]);
+        free_nodes(tree);
+    }
+    return test_finish(failures, "AVL");
+}
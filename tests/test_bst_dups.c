@@ -0,0 +1,219 @@
+/**
+ * test_bst_dups.c - duplicate-timestamp insert policies
+ *
+ * @file:               test_bst_dups.c
+ * @author:             Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Inserts bursts of readings for one timestamp under every bst_dup_policy_t, with
+ * and without an arena, and checks the insert results, the readings
+ * search_tree_all() returns, the aggregates and the in-order walk.  Then inserts
+ * through insert_node_cow() over nodes holding several readings, retiring replaced
+ * nodes straight away with destroy_node(), and checks that the new version still
+ * returns every reading.  Last, mixes policies on one timestamp to pin down that
+ * BST_DUP_OVERWRITE replaces only the first node holding it.  Exits non-zero on
+ * failure.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "bst.h"
+#include "test_util.h"
+
+#define NUM_KEYS    64      // timestamps in the tree
+#define DUP_KEY     20      // timestamp that collects the duplicate readings
+#define DUP_READS   6       // readings inserted for DUP_KEY, the first with the other keys
+
+static const char* policy_name(bst_dup_policy_t policy) {
+    switch (policy) {
+    case BST_DUP_CHAIN:       return "chain";
+    case BST_DUP_REJECT:      return "reject";
+    case BST_DUP_OVERWRITE:   return "overwrite";
+    case BST_DUP_KEEP_LATEST: return "keep_latest";
+    default:                  return "multi";
+    }
+}
+
+// Reading i of the DUP_KEY burst, i == 0 is the one inserted with the other keys
+static temp_humid_data_t dup_reading(int i) {
+    temp_humid_data_t data = {DUP_KEY, (uint32_t)(i == 0 ? DUP_KEY : 100 + i), (uint32_t)(i == 0 ? DUP_KEY : 200 + i)};
+    return data;
+}
+
+// The insert_node_policy() result expected for burst reading i
+static int expected_status(bst_dup_policy_t policy, int i) {
+    switch (policy) {
+    case BST_DUP_CHAIN:       return BST_INSERT_ADDED;
+    case BST_DUP_REJECT:      return BST_INSERT_REJECTED;
+    case BST_DUP_OVERWRITE:   return BST_INSERT_REPLACED;
+    case BST_DUP_KEEP_LATEST: return (i < BST_DUP_LATEST_MAX) ? BST_INSERT_APPENDED : BST_INSERT_REPLACED;
+    default:                  return BST_INSERT_APPENDED;
+    }
+}
+
+static int run_case(bst_dup_policy_t policy, int use_arena) {
+    const char* name = policy_name(policy);
+    const char* where = use_arena ? "arena" : "malloc";
+    bst_arena_ptr_t arena = use_arena ? create_arena(0) : NULL;
+    bst_node_ptr_t tree = NULL;
+    int failures = 0;
+
+    for (int k = 0; k < NUM_KEYS; k++) {
+        temp_humid_data_t data = {k, (uint32_t)k, (uint32_t)k};
+        failures += test_check(insert_node_policy(&tree, data, arena, policy) == BST_INSERT_ADDED,
+                               "insert of key %d (%s, %s)", k, name, where);
+    }
+    int height = tree_height(tree);
+    for (int i = 1; i < DUP_READS; i++) {
+        failures += test_check(insert_node_policy(&tree, dup_reading(i), arena, policy) == expected_status(policy, i),
+                               "insert result of duplicate %d (%s, %s)", i, name, where);
+    }
+
+    // Which burst readings each policy keeps, oldest first
+    int first, held;
+    switch (policy) {
+    case BST_DUP_REJECT:      first = 0; held = 1; break;
+    case BST_DUP_OVERWRITE:   first = DUP_READS - 1; held = 1; break;
+    case BST_DUP_KEEP_LATEST: first = DUP_READS - BST_DUP_LATEST_MAX; held = BST_DUP_LATEST_MAX; break;
+    default:                  first = 0; held = DUP_READS; break;
+    }
+
+    temp_humid_data_t found[DUP_READS + 1];
+    size_t n = search_tree_all(tree, DUP_KEY, found, DUP_READS + 1);
+    failures += test_check(n == (size_t)held, "readings held (%s, %s): %zu, want %d", name, where, n, held);
+
+    // Chained readings come back in tree order, so only their sum is compared
+    uint64_t want_sum = 0, got_sum = 0;
+    int in_order = 1;
+    for (int i = 0; i < held && (size_t)i < n; i++) {
+        temp_humid_data_t want = dup_reading(first + i);
+        want_sum += want.temp;
+        got_sum += found[i].temp;
+        if (found[i].timestamp != DUP_KEY || found[i].temp != want.temp || found[i].humid != want.humid) in_order = 0;
+    }
+    if (policy == BST_DUP_CHAIN) {
+        failures += test_check(got_sum == want_sum, "chained readings (%s, %s)", name, where);
+    } else {
+        failures += test_check(in_order, "readings kept, oldest first (%s, %s)", name, where);
+        failures += test_check(tree_height(tree) == height, "duplicates add no depth (%s, %s)", name, where);
+    }
+
+    bst_agg_t agg;
+    failures += test_check(aggregate_range(tree, DUP_KEY, DUP_KEY, BST_RANGE_INCLUSIVE, &agg) == (uint64_t)held
+                           && agg.temp_sum == want_sum, "aggregate of the duplicates (%s, %s)", name, where);
+    failures += test_check(tree->agg.count == (uint64_t)(NUM_KEYS - 1 + held), "root aggregate (%s, %s)", name, where);
+
+    test_order_t walk = TEST_ORDER_INIT;
+    traverse_in_order(tree, test_check_order, &walk);
+    failures += test_check(walk.count == (size_t)(NUM_KEYS - 1 + held) && walk.ordered, "in-order walk (%s, %s)",
+                           name, where);
+
+    if (use_arena) {
+        destroy_arena(arena);
+    } else {
+        destroy_tree(tree, NULL);
+    }
+    return failures;
+}
+
+// insert_node_cow() retire callback: free the replaced node at once, the worst case
+static void retire_now(bst_node_ptr_t node, void* ctx) {
+    destroy_node(node, (bst_arena_ptr_t)ctx);
+}
+
+static int run_cow_case(bst_dup_policy_t policy, int use_arena) {
+    const char* name = policy_name(policy);
+    const char* where = use_arena ? "arena" : "malloc";
+    bst_arena_ptr_t arena = use_arena ? create_arena(0) : NULL;
+    bst_node_ptr_t tree = NULL;
+    int failures = 0;
+
+    for (int k = 0; k < NUM_KEYS; k++) {
+        temp_humid_data_t data = {k, (uint32_t)k, (uint32_t)k};
+        insert_node_policy(&tree, data, arena, policy);
+    }
+    for (int i = 1; i < DUP_READS; i++) {
+        insert_node_policy(&tree, dup_reading(i), arena, policy);
+    }
+
+    // Readings held for DUP_KEY before the copy-on-write inserts
+    temp_humid_data_t expected[DUP_READS];
+    size_t held = search_tree_all(tree, DUP_KEY, expected, DUP_READS);
+
+    // Both inserts walk through the DUP_KEY node, so it is copied and retired
+    temp_humid_data_t chained = {DUP_KEY, 300, 400};
+    temp_humid_data_t next = {DUP_KEY + 1, 500, 600};
+    tree = insert_node_cow(tree, chained, arena, retire_now, arena);
+    tree = insert_node_cow(tree, next, arena, retire_now, arena);
+
+    temp_humid_data_t found[DUP_READS + 1];
+    size_t n = search_tree_all(tree, DUP_KEY, found, DUP_READS + 1);
+    failures += test_check(n == held + 1, "reading count after copy-on-write (%s, %s)", name, where);
+
+    // The node's own readings come out in order; the chained one sits in its own node
+    size_t matched = 0;
+    for (size_t i = 0; i < n && matched < held; i++) {
+        if (memcmp(&found[i], &expected[matched], sizeof(found[i])) == 0) matched++;
+    }
+    failures += test_check(matched == held, "duplicate readings survive copy-on-write (%s, %s)", name, where);
+
+    bst_agg_t agg;
+    aggregate_range(tree, DUP_KEY, DUP_KEY, BST_RANGE_INCLUSIVE, &agg);
+    failures += test_check(agg.count == held + 1, "aggregate after copy-on-write (%s, %s)", name, where);
+    failures += test_check(tree->agg.count == NUM_KEYS + held + 1, "root aggregate after copy-on-write (%s, %s)",
+                           name, where);
+
+    if (use_arena) {
+        destroy_arena(arena);
+    } else {
+        destroy_tree(tree, NULL);
+    }
+    return failures;
+}
+
+// Chained readings 0, 1, 2 then an overwrite with 99: only the first node found changes
+static int run_mixed_case(int use_arena) {
+    const char* where = use_arena ? "arena" : "malloc";
+    bst_arena_ptr_t arena = use_arena ? create_arena(0) : NULL;
+    bst_node_ptr_t tree = NULL;
+    int failures = 0;
+
+    for (uint32_t v = 0; v < 3; v++) {
+        temp_humid_data_t data = {DUP_KEY, v, v};
+        insert_node_policy(&tree, data, arena, BST_DUP_CHAIN);
+    }
+    temp_humid_data_t data = {DUP_KEY, 99, 99};
+    failures += test_check(insert_node_policy(&tree, data, arena, BST_DUP_OVERWRITE) == BST_INSERT_REPLACED,
+                           "overwrite of chained readings (%s)", where);
+
+    temp_humid_data_t found[4];
+    size_t n = search_tree_all(tree, DUP_KEY, found, 4);
+    failures += test_check(n == 3 && found[0].temp == 2 && found[1].temp == 99 && found[2].temp == 0,
+                           "overwrite replaces the first node only (%s)", where);
+    failures += test_check(tree->agg.count == 3 && tree->agg.temp_sum == 101, "aggregate after overwrite (%s)", where);
+
+    if (use_arena) {
+        destroy_arena(arena);
+    } else {
+        destroy_tree(tree, NULL);
+    }
+    return failures;
+}
+
+int main(void) {
+    const bst_dup_policy_t policies[] = {BST_DUP_CHAIN, BST_DUP_REJECT, BST_DUP_OVERWRITE, BST_DUP_KEEP_LATEST,
+                                         BST_DUP_MULTI};
+    int failures = 0;
+
+    for (int use_arena = 0; use_arena < 2; use_arena++) {
+        for (size_t p = 0; p < sizeof(policies) / sizeof(policies[0]); p++) {
+            failures += run_case(policies[p], use_arena);
+        }
+        failures += run_cow_case(BST_DUP_MULTI, use_arena);
+        failures += run_cow_case(BST_DUP_KEEP_LATEST, use_arena);
+        failures += run_mixed_case(use_arena);
+    }
+    return test_finish(failures, "duplicate policy");
+}
@@ -0,0 +1,86 @@
+/**
+ * test_bst_frozen.c - lookups in the frozen Eytzinger index
+ *
+ * @file:               test_bst_frozen.c
+ * @author:             Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Freezes trees of several sizes, including empty and single-node ones, and
+ * checks single and batched lookups of every stored timestamp and of the gaps
+ * between them, against both the frozen index and the tree it came from, plus the
+ * ordered traversal.  Exits non-zero on failure.
+ *
+ */
+
+#include <stdlib.h>
+#include "bst_frozen.h"
+#include "test_util.h"
+
+#define MAX_KEYS    1000    // stored timestamps are 0, 3, 6, ...
+#define STEP        3
+
+static int run_case(int size) {
+    bst_node_ptr_t tree = NULL;
+    int failures = 0;
+
+    for (int i = 0; i < size; i++) {
+        temp_humid_data_t data = {(time_t)i * STEP, (uint32_t)i, (uint32_t)(i + 1)};
+        insert_node(&tree, data);
+    }
+    bst_frozen_ptr_t frozen = freeze_tree(tree);
+    if (frozen == NULL) {
+        destroy_tree(tree, NULL);
+        return test_check(0, "freeze_tree (%d keys)", size);
+    }
+    failures += test_check(frozen->size == (size_t)size, "frozen size (%d keys)", size);
+
+    // Every stored timestamp and the gaps on both sides of it, including past both ends
+    int probes = size * STEP + 2;
+    time_t* keys = (time_t*)malloc(probes * sizeof(time_t));
+    temp_humid_data_ptr_t* found = (temp_humid_data_ptr_t*)malloc(probes * sizeof(temp_humid_data_ptr_t));
+    bst_node_ptr_t* nodes = (bst_node_ptr_t*)malloc(probes * sizeof(bst_node_ptr_t));
+    for (int p = 0; p < probes; p++) {
+        keys[p] = (time_t)p - 1;
+    }
+    search_frozen_batch(frozen, keys, probes, found);
+    search_tree_batch(tree, keys, probes, nodes);
+
+    int wrong = 0;
+    for (int p = 0; p < probes; p++) {
+        time_t ts = keys[p];
+        int stored = ts >= 0 && ts % STEP == 0 && ts / STEP < size;
+        temp_humid_data_ptr_t single = search_frozen(frozen, ts);
+        if (stored) {
+            if (single == NULL || single->timestamp != ts || single->temp != (uint32_t)(ts / STEP)) wrong++;
+        } else if (single != NULL) {
+            wrong++;
+        }
+        if (found[p] != single) wrong++;
+        if (nodes[p] != search_tree(tree, ts)) wrong++;
+    }
+    failures += test_check(wrong == 0, "single and batched lookups (%d keys)", size);
+
+    test_order_t order = TEST_ORDER_INIT;
+    failures += test_check(traverse_frozen(frozen, test_check_order, &order) == (size_t)size,
+                           "traversal count (%d keys)", size);
+    failures += test_check(order.count == (size_t)size && order.ordered, "traversal order (%d keys)", size);
+
+    free(nodes);
+    free(found);
+    free(keys);
+    destroy_frozen(frozen);
+    destroy_tree(tree, NULL);
+    return failures;
+}
+
+int main(void) {
+    // Sizes around the powers of two where the Eytzinger layout changes depth
+    const int sizes[] = {0, 1, 2, 7, 8, 9, 63, 64, 65, 100, MAX_KEYS};
+    int failures = 0;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        failures += run_case(sizes[s]);
+    }
+    return test_finish(failures, "frozen index");
+}
@@ -0,0 +1,105 @@
+/**
+ * test_bst_parallel.c - parallel sort and build against the single-threaded ones
+ *
+ * @file:               test_bst_parallel.c
+ * @author:             Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Sorts and builds trees from scrambled readings with negative timestamps and
+ * many duplicates, for sizes above the parallel cut-off and thread counts that do
+ * not divide them.  sort_by_timestamp_parallel() must order the readings like
+ * sort_by_timestamp(), and create_tree_parallel() must build the same tree, node
+ * for node, as create_tree_sorted(), with and without an arena.  Exits non-zero
+ * on failure.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "bst.h"
+#include "test_util.h"
+
+// Both node for node equal: same readings, heights and aggregates in the same shape
+static int same_tree(bst_node_ptr_t a, bst_node_ptr_t b) {
+    if (a == NULL || b == NULL) return a == b;
+    return a->data.timestamp == b->data.timestamp && a->height == b->height
+           && a->agg.count == b->agg.count && a->agg.temp_sum == b->agg.temp_sum
+           && same_tree(a->left, b->left) && same_tree(a->right, b->right);
+}
+
+// Scrambled readings around zero, each timestamp about three times
+static void fill(temp_humid_data_t* arr, int size) {
+    uint64_t x = 88172645463325252ull;
+    for (int i = 0; i < size; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        arr[i].timestamp = (time_t)(x % (uint64_t)(size / 3 + 1)) - size / 6;
+        arr[i].temp = (uint32_t)i;
+        arr[i].humid = (uint32_t)(x >> 40);
+    }
+}
+
+static int sorted_same(const temp_humid_data_t* a, const temp_humid_data_t* b, int size) {
+    for (int i = 0; i < size; i++) {
+        if (a[i].timestamp != b[i].timestamp) return 0;
+    }
+    return 1;
+}
+
+static int run_case(int size, int nthreads, int use_arena) {
+    temp_humid_data_t* input = (temp_humid_data_t*)malloc(size * sizeof(temp_humid_data_t));
+    temp_humid_data_t* serial = (temp_humid_data_t*)malloc(size * sizeof(temp_humid_data_t));
+    temp_humid_data_t* parallel = (temp_humid_data_t*)malloc(size * sizeof(temp_humid_data_t));
+    bst_arena_ptr_t arena = use_arena ? create_arena(0) : NULL;
+    int failures = 0;
+
+    fill(input, size);
+    memcpy(serial, input, size * sizeof(temp_humid_data_t));
+    memcpy(parallel, input, size * sizeof(temp_humid_data_t));
+    failures += test_check(sort_by_timestamp(serial, size) == 0
+                           && sort_by_timestamp_parallel(parallel, size, nthreads) == 0,
+                           "sorts succeed (%d readings, %d threads)", size, nthreads);
+    failures += test_check(is_sorted_by_timestamp(parallel, size) && sorted_same(serial, parallel, size),
+                           "parallel sort order (%d readings, %d threads)", size, nthreads);
+
+    // Both builds start from the same scrambled input
+    memcpy(serial, input, size * sizeof(temp_humid_data_t));
+    memcpy(parallel, input, size * sizeof(temp_humid_data_t));
+    bst_node_ptr_t want = create_tree_sorted(serial, size, arena);
+    bst_node_ptr_t got = create_tree_parallel(parallel, size, arena, nthreads);
+    failures += test_check(want != NULL && got != NULL, "builds succeed (%d readings, %d threads, %s)", size,
+                           nthreads, use_arena ? "arena" : "malloc");
+    failures += test_check(same_tree(want, got), "same tree (%d readings, %d threads, %s)", size, nthreads,
+                           use_arena ? "arena" : "malloc");
+    failures += test_check(got != NULL && got->agg.count == (uint64_t)size, "tree size (%d readings, %d threads)",
+                           size, nthreads);
+
+    if (use_arena) {
+        destroy_arena(arena);
+    } else {
+        destroy_tree(want, NULL);
+        destroy_tree(got, NULL);
+    }
+    free(parallel);
+    free(serial);
+    free(input);
+    return failures;
+}
+
+int main(void) {
+    // Above the parallel cut-off, none a multiple of the thread counts above 1
+    const int sizes[] = {70001, 131071};
+    const int threads[] = {1, 2, 3, 5, 7};
+    int failures = 0;
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (size_t t = 0; t < sizeof(threads) / sizeof(threads[0]); t++) {
+            for (int use_arena = 0; use_arena < 2; use_arena++) {
+                failures += run_case(sizes[s], threads[t], use_arena);
+            }
+        }
+    }
+    return test_finish(failures, "parallel build");
+}
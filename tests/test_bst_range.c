@@ -0,0 +1,120 @@
+/**
+ * test_bst_range.c - range bounds and subtree aggregates with duplicate timestamps
+ *
+ * @file:               test_bst_range.c
+ * @author:             Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Builds trees in which many readings share a timestamp, both as chained nodes
+ * (BST_DUP_CHAIN) and held in one node (BST_DUP_MULTI), then compares
+ * range_query(), range_query_buffer() and aggregate_range() against a scan of the
+ * inserted readings for windows with every combination of inclusive and exclusive
+ * bounds.  Exits non-zero on failure.
+ *
+ */
+
+#include "bst.h"
+#include "test_util.h"
+
+#define NUM_READS   600     // timestamps 0 .. MAX_TS, about four readings each
+#define MAX_TS      (NUM_READS / 4)
+
+typedef struct {
+    time_t low;
+    time_t high;
+    test_order_t order;
+    int inside;
+} window_check_t;
+
+static int check_window(const temp_humid_data_t* data, void* ctx) {
+    window_check_t* window = (window_check_t*)ctx;
+    if (data->timestamp < window->low || data->timestamp > window->high) window->inside = 0;
+    return test_check_order(data, &window->order);
+}
+
+// Aggregates of the readings in [low, high], by scanning them
+static void scan(const temp_humid_data_t* reads, size_t n, time_t low, time_t high, bst_agg_t* out) {
+    bst_agg_t agg = {0, 0, 0, UINT32_MAX, 0, UINT32_MAX, 0};
+    for (size_t i = 0; i < n; i++) {
+        if (reads[i].timestamp < low || reads[i].timestamp > high) continue;
+        agg.count++;
+        agg.temp_sum += reads[i].temp;
+        agg.humid_sum += reads[i].humid;
+        if (reads[i].temp < agg.temp_min) agg.temp_min = reads[i].temp;
+        if (reads[i].temp > agg.temp_max) agg.temp_max = reads[i].temp;
+        if (reads[i].humid < agg.humid_min) agg.humid_min = reads[i].humid;
+        if (reads[i].humid > agg.humid_max) agg.humid_max = reads[i].humid;
+    }
+    *out = agg;
+}
+
+static int same_agg(const bst_agg_t* a, const bst_agg_t* b) {
+    if (a->count != b->count) return 0;
+    if (a->count == 0) return a->temp_min > a->temp_max && a->humid_min > a->humid_max;
+    return a->temp_sum == b->temp_sum && a->humid_sum == b->humid_sum
+           && a->temp_min == b->temp_min && a->temp_max == b->temp_max
+           && a->humid_min == b->humid_min && a->humid_max == b->humid_max;
+}
+
+static int run_case(bst_dup_policy_t policy, const char* name) {
+    temp_humid_data_t reads[NUM_READS], copied[NUM_READS];
+    bst_arena_ptr_t arena = create_arena(0);
+    bst_node_ptr_t tree = NULL;
+    int failures = 0;
+
+    // Scrambled timestamps with readings that differ, so sums, mins and maxes all matter
+    for (int i = 0; i < NUM_READS; i++) {
+        reads[i].timestamp = (time_t)(((uint64_t)i * 37) % (MAX_TS + 1));
+        reads[i].temp = (uint32_t)((i * 7919) % 1000);
+        reads[i].humid = (uint32_t)((i * 104729) % 5000);
+        if (insert_node_policy(&tree, reads[i], arena, policy) < 0) {
+            destroy_arena(arena);
+            return test_check(0, "insert (%s)", name);
+        }
+    }
+
+    bst_agg_t want, got;
+    scan(reads, NUM_READS, -1, MAX_TS + 1, &want);
+    failures += test_check(same_agg(&tree->agg, &want), "root aggregate (%s)", name);
+
+    const time_t bounds[][2] = {{0, 0}, {5, 5}, {5, 6}, {0, MAX_TS}, {10, 90}, {-20, 3}, {MAX_TS - 2, MAX_TS + 9},
+                                {40, 39}, {MAX_TS + 1, MAX_TS + 5}};
+    for (size_t b = 0; b < sizeof(bounds) / sizeof(bounds[0]); b++) {
+        for (int flags = 0; flags < 4; flags++) {
+            time_t low = bounds[b][0], high = bounds[b][1];
+            time_t scan_low = (flags & BST_RANGE_EXCLUDE_LOW) ? low + 1 : low;
+            time_t scan_high = (flags & BST_RANGE_EXCLUDE_HIGH) ? high - 1 : high;
+            scan(reads, NUM_READS, scan_low, scan_high, &want);
+
+            window_check_t window = {scan_low, scan_high, TEST_ORDER_INIT, 1};
+            size_t visited = range_query(tree, low, high, flags, 0, check_window, &window);
+            failures += test_check(visited == want.count && window.order.count == want.count
+                                   && window.order.ordered && window.inside,
+                                   "range_query [%ld, %ld] flags %d (%s): %zu readings, want %llu", (long)low,
+                                   (long)high, flags, name, visited, (unsigned long long)want.count);
+
+            size_t limit = (size_t)(want.count / 2);
+            size_t n = range_query_buffer(tree, low, high, flags, copied, limit);
+            failures += test_check(n == limit, "range_query_buffer limit [%ld, %ld] flags %d (%s)", (long)low,
+                                   (long)high, flags, name);
+
+            uint64_t count = aggregate_range(tree, low, high, flags, &got);
+            failures += test_check(count == want.count && same_agg(&got, &want),
+                                   "aggregate_range [%ld, %ld] flags %d (%s): %llu readings, want %llu",
+                                   (long)low, (long)high, flags, name, (unsigned long long)count,
+                                   (unsigned long long)want.count);
+        }
+    }
+
+    destroy_arena(arena);
+    return failures;
+}
+
+int main(void) {
+    int failures = 0;
+
+    failures += run_case(BST_DUP_CHAIN, "chain");
+    failures += run_case(BST_DUP_MULTI, "multi");
+    return test_finish(failures, "range and aggregate");
+}
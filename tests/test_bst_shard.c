@@ -0,0 +1,88 @@
+/**
+ * test_bst_shard.c - sharded index flush, counts and range merging
+ *
+ * @file:               test_bst_shard.c
+ * @author:             Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Feeds time-ordered readings, some sharing a timestamp, through a sharded index
+ * with minute buckets, then checks that shard_flush() reports no failures, that
+ * shard_count() and shard_failed() add up, and that range queries and aggregates
+ * across bucket and shard boundaries come back in timestamp order with the right
+ * counts.  Exits non-zero on failure.
+ *
+ */
+
+#include "bst_shard.h"
+#include "test_util.h"
+
+#define NUM_SHARDS  4
+#define NUM_READS   5000    // one reading every STEP seconds, every tenth one repeated
+#define STEP        7
+
+// Readings the test inserted with timestamps in [low, high]
+static size_t expected_in(time_t low, time_t high) {
+    size_t count = 0;
+    for (size_t i = 0; i < NUM_READS; i++) {
+        time_t ts = (time_t)(i * STEP);
+        if (ts >= low && ts <= high) count += (i % 10 == 0) ? 2 : 1;
+    }
+    return count;
+}
+
+int main(void) {
+    shard_index_ptr_t index = create_shard_index(NUM_SHARDS, SHARD_BUCKET_MINUTE);
+    int failures = 0;
+    size_t total = 0;
+
+    if (index == NULL) {
+        return test_finish(test_check(0, "create_shard_index"), "shard");
+    }
+    for (size_t i = 0; i < NUM_READS; i++) {
+        temp_humid_data_t data = {(time_t)(i * STEP), (uint32_t)i, (uint32_t)i};
+        shard_insert(index, &data, 1);
+        total++;
+        if (i % 10 == 0) {
+            data.temp += 1;
+            shard_insert(index, &data, 1);
+            total++;
+        }
+    }
+    failures += test_check(shard_flush(index) == 0, "shard_flush reports no failures");
+    failures += test_check(shard_failed(index) == 0, "shard_failed is zero");
+    failures += test_check(shard_count(index) == total, "shard_count covers every reading");
+
+    // Windows inside one bucket, across buckets and shards, and past both ends
+    const time_t windows[][2] = {{0, 0}, {61, 119}, {55, 65}, {100, 2000}, {-500, 300}, {0, NUM_READS * STEP}};
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        time_t low = windows[w][0], high = windows[w][1];
+        test_order_t order = TEST_ORDER_INIT;
+        size_t visited = shard_range_query(index, low, high, BST_RANGE_INCLUSIVE, 0, test_check_order, &order);
+        size_t want = expected_in(low, high);
+        failures += test_check(visited == want && order.count == want, "range query count [%ld, %ld]",
+                               (long)low, (long)high);
+        failures += test_check(order.ordered, "range query order [%ld, %ld]", (long)low, (long)high);
+
+        bst_agg_t agg;
+        failures += test_check(shard_aggregate(index, low, high, BST_RANGE_INCLUSIVE, &agg) == want,
+                               "aggregate count [%ld, %ld]", (long)low, (long)high);
+    }
+
+    // Exclusive bounds drop the readings on the bound
+    test_order_t order = TEST_ORDER_INIT;
+    size_t visited = shard_range_query(index, 70, 140, BST_RANGE_EXCLUDE_LOW | BST_RANGE_EXCLUDE_HIGH, 0,
+                                       test_check_order, &order);
+    failures += test_check(visited == expected_in(71, 139), "exclusive bounds");
+
+    // A limit stops the merge early
+    order = (test_order_t)TEST_ORDER_INIT;
+    visited = shard_range_query(index, 0, NUM_READS * STEP, BST_RANGE_INCLUSIVE, 25, test_check_order, &order);
+    failures += test_check(visited == 25 && order.count == 25 && order.ordered, "limit");
+
+    failures += test_check(shard_search(index, 700) != NULL, "search finds a stored timestamp");
+    failures += test_check(shard_search(index, 701) == NULL, "search misses an absent timestamp");
+
+    destroy_shard_index(index);
+    return test_finish(failures, "shard");
+}
@@ -0,0 +1,149 @@
+/**
+ * test_bst_snapshot.c - snapshot round trip and header validation
+ *
+ * @file:               test_bst_snapshot.c
+ * @author:             Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Saves a frozen index, maps it back and checks its lookups, then rewrites one
+ * header field at a time (magic, version, sizes, offsets) or truncates the file and
+ * checks that open_snapshot() rejects every damaged copy.  Exits non-zero on
+ * failure.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "bst_snapshot.h"
+#include "test_util.h"
+
+#define NUM_KEYS    500
+
+static unsigned char* read_file(const char* path, long* size) {
+    FILE* f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+    fseek(f, 0, SEEK_END);
+    *size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    unsigned char* buf = (unsigned char*)malloc(*size);
+    if (buf != NULL && fread(buf, 1, *size, f) != (size_t)*size) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    return buf;
+}
+
+static int write_file(const char* path, const unsigned char* buf, long size) {
+    FILE* f = fopen(path, "wb");
+    if (f == NULL) return -1;
+    int rtn = (fwrite(buf, 1, size, f) == (size_t)size) ? 0 : -1;
+    fclose(f);
+    return rtn;
+}
+
+// Writes image with the header replaced by header and expects open_snapshot() to refuse it
+static int expect_rejected(const char* path, const unsigned char* image, long size,
+                           const snapshot_header_t* header, const char* what) {
+    unsigned char* copy = (unsigned char*)malloc(size);
+    memcpy(copy, image, size);
+    memcpy(copy, header, sizeof(*header));
+    int failures = test_check(write_file(path, copy, size) == 0, "write damaged copy (%s)", what);
+    bst_snapshot_ptr_t snapshot = open_snapshot(path);
+    failures += test_check(snapshot == NULL, "damaged header accepted (%s)", what);
+    close_snapshot(snapshot);
+    free(copy);
+    return failures;
+}
+
+int main(void) {
+    char dir[] = "/tmp/test_snapshot_XXXXXX";
+    char path[64], damaged[64];
+    int failures = 0;
+
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    snprintf(path, sizeof(path), "%s/index.snap", dir);
+    snprintf(damaged, sizeof(damaged), "%s/damaged.snap", dir);
+
+    bst_node_ptr_t tree = NULL;
+    for (int i = 0; i < NUM_KEYS; i++) {
+        temp_humid_data_t data = {(time_t)i * 2, (uint32_t)i, (uint32_t)i * 3};
+        insert_node(&tree, data);
+    }
+    bst_frozen_ptr_t frozen = freeze_tree(tree);
+    failures += test_check(frozen != NULL && save_snapshot(frozen, path) == 0, "save_snapshot");
+
+    // Round trip
+    bst_snapshot_ptr_t snapshot = open_snapshot(path);
+    failures += test_check(snapshot != NULL, "open_snapshot");
+    if (snapshot != NULL) {
+        failures += test_check(snapshot->frozen.size == NUM_KEYS, "snapshot size");
+        int wrong = 0;
+        for (int i = 0; i < NUM_KEYS * 2; i++) {
+            temp_humid_data_ptr_t found = search_frozen(&snapshot->frozen, i);
+            if ((i % 2 == 0) != (found != NULL)) wrong++;
+            if (found != NULL && (found->temp != (uint32_t)(i / 2) || found->humid != (uint32_t)(i / 2) * 3)) wrong++;
+        }
+        failures += test_check(wrong == 0, "snapshot lookups");
+        close_snapshot(snapshot);
+    }
+
+    long size = 0;
+    unsigned char* image = read_file(path, &size);
+    if (image == NULL || size < (long)sizeof(snapshot_header_t)) {
+        return test_finish(test_check(0, "read snapshot file"), "snapshot");
+    }
+    snapshot_header_t good;
+    memcpy(&good, image, sizeof(good));
+    snapshot_header_t bad;
+
+    bad = good; bad.magic[0] ^= 1;
+    failures += expect_rejected(damaged, image, size, &bad, "magic");
+    bad = good; bad.version++;
+    failures += expect_rejected(damaged, image, size, &bad, "version");
+    bad = good; bad.byte_order = 0x04030201u;
+    failures += expect_rejected(damaged, image, size, &bad, "byte order");
+    bad = good; bad.key_size = 4;
+    failures += expect_rejected(damaged, image, size, &bad, "key size");
+    bad = good; bad.record_size++;
+    failures += expect_rejected(damaged, image, size, &bad, "record size");
+    bad = good; bad.file_size++;
+    failures += expect_rejected(damaged, image, size, &bad, "file size");
+    bad = good; bad.size += SNAPSHOT_ALIGN;
+    failures += expect_rejected(damaged, image, size, &bad, "reading count too large");
+    bad = good; bad.size = UINT64_MAX / sizeof(time_t);
+    failures += expect_rejected(damaged, image, size, &bad, "reading count that wraps");
+    bad = good; bad.keys_offset += 1;
+    failures += expect_rejected(damaged, image, size, &bad, "misaligned keys");
+    bad = good; bad.keys_offset = 0;
+    failures += expect_rejected(damaged, image, size, &bad, "keys over the header");
+    bad = good; bad.data_offset = good.keys_offset - SNAPSHOT_ALIGN;
+    failures += expect_rejected(damaged, image, size, &bad, "data before keys");
+    bad = good; bad.data_offset = UINT64_MAX - SNAPSHOT_ALIGN + 1;
+    failures += expect_rejected(damaged, image, size, &bad, "data past the end");
+
+    // A file cut short, with its header still claiming the full size
+    failures += test_check(write_file(damaged, image, size - 1) == 0, "write truncated copy");
+    snapshot = open_snapshot(damaged);
+    failures += test_check(snapshot == NULL, "truncated file rejected");
+    close_snapshot(snapshot);
+
+    // And one too short to hold a header at all
+    failures += test_check(write_file(damaged, image, sizeof(snapshot_header_t) - 1) == 0, "write stub");
+    snapshot = open_snapshot(damaged);
+    failures += test_check(snapshot == NULL, "stub file rejected");
+    close_snapshot(snapshot);
+
+    free(image);
+    destroy_frozen(frozen);
+    destroy_tree(tree, NULL);
+    unlink(damaged);
+    unlink(path);
+    rmdir(dir);
+    return test_finish(failures, "snapshot");
+}
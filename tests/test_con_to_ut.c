@@ -0,0 +1,71 @@
+/**
+ * test_con_to_ut.c - date to timestamp conversion, single and batched
+ *
+ * @file:               test_con_to_ut.c
+ * @author:             Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Checks con_to_ut() against known midnight-UTC timestamps, then converts dates
+ * across the documented range of con_to_ut_batch(), from year -10000 to 300
+ * million, including out of range months and days, and compares each result with
+ * con_to_ut_offset().  Exits non-zero on failure.
+ *
+ */
+
+#include "bst.h"
+#include "test_util.h"
+
+#define MAX_DATES   2048    // dates converted in one batch
+
+static const int years[] = {
+    -10000, -4713, -1, 0, 1, 1600, 1900, 1969, 1970, 2000, 2024, 2100, 9999,
+    11000000, 11758000, 12000000, 50000000, 100000000, 299999999, 300000000
+};
+
+static const int months[] = {-13, -1, 0, 1, 2, 3, 6, 12, 13, 25};
+static const int days[] = {-31, 0, 1, 28, 29, 31, 60};
+
+int main(void) {
+    static int month[MAX_DATES], day[MAX_DATES], year[MAX_DATES];
+    static time_t out[MAX_DATES];
+    const long offsets[] = {0, -25200, 19800};
+    int failures = 0;
+    size_t n = 0;
+
+    // Midnight UTC whatever the local time zone, with months and days rolling over
+    int fm[] = {1, 3, 1, 13, 3}, fd[] = {1, 1, 1, 1, 0}, fy[] = {1970, 2000, 2038, 1969, 2000};
+    const time_t fixed_want[] = {0, 951868800, 2145916800, 0, 951782400};
+    time_t fixed[5];
+    con_to_ut_batch(fm, fd, fy, 5, 0, fixed);
+    for (int i = 0; i < 5; i++) {
+        time_t single = con_to_ut(fm[i], fd[i], fy[i]);
+        failures += test_check(single == fixed_want[i] && fixed[i] == fixed_want[i],
+                               "%d-%d-%d: single %lld, batch %lld, want %lld", fy[i], fm[i], fd[i],
+                               (long long)single, (long long)fixed[i], (long long)fixed_want[i]);
+    }
+
+    for (size_t y = 0; y < sizeof(years) / sizeof(years[0]); y++) {
+        for (size_t m = 0; m < sizeof(months) / sizeof(months[0]); m++) {
+            for (size_t d = 0; d < sizeof(days) / sizeof(days[0]) && n < MAX_DATES; d++) {
+                // Keep both ends of the range inside it once months carry across a year
+                if (years[y] == -10000 && months[m] < 3) continue;
+                if (years[y] == 300000000 && months[m] > 12) continue;
+                year[n] = years[y];
+                month[n] = months[m];
+                day[n] = days[d];
+                n++;
+            }
+        }
+    }
+
+    for (size_t o = 0; o < sizeof(offsets) / sizeof(offsets[0]); o++) {
+        con_to_ut_batch(month, day, year, n, offsets[o], out);
+        for (size_t i = 0; i < n; i++) {
+            time_t want = con_to_ut_offset(month[i], day[i], year[i], offsets[o]);
+            failures += test_check(out[i] == want, "%d-%d-%d offset %ld: batch %lld, single %lld", year[i],
+                                   month[i], day[i], offsets[o], (long long)out[i], (long long)want);
+        }
+    }
+    return test_finish(failures, "date conversion");
+}
@@ -0,0 +1,159 @@
+/**
+ * test_ingest_csv.c - CSV and binary log parsing
+ *
+ * @file:               test_ingest_csv.c
+ * @author:             Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Streams in-memory logs through ingest_stream() with fmemopen() and checks which
+ * lines become readings and which are skipped: a header, malformed and short rows,
+ * an extra column, negative timestamps, values past UINT32_MAX, fractions, padding
+ * and CRLF line endings.  Also checks the counts when the sink stops the stream,
+ * round-trips readings through the binary format and loads a log into a tree with
+ * ingest_into_tree().  Exits non-zero on failure.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "ingest.h"
+#include "test_util.h"
+
+#define MAX_READS   16
+
+typedef struct {
+    temp_humid_data_t reads[MAX_READS];
+    size_t count;       // readings kept in reads
+    size_t taken;       // readings in every batch accepted
+    size_t accept;      // batches accepted before the sink asks to stop
+    size_t batches;
+} collect_t;
+
+static int collect(const temp_humid_data_t* batch, size_t n, void* ctx) {
+    collect_t* out = (collect_t*)ctx;
+    if (out->batches++ >= out->accept) return 1;
+    for (size_t i = 0; i < n && out->count < MAX_READS; i++) {
+        out->reads[out->count++] = batch[i];
+    }
+    out->taken += n;
+    return 0;
+}
+
+static int same(const temp_humid_data_t* a, time_t ts, uint32_t temp, uint32_t humid) {
+    return a->timestamp == ts && a->temp == temp && a->humid == humid;
+}
+
+static int run_csv(void) {
+    static const char log[] =
+        "timestamp,temp,humid\n"                // header
+        "1000,21,45\n"
+        "1001,21.9,45.5\n"                      // fractions are dropped
+        "  1002 , 22 , 46  \n"                  // padding is trimmed
+        "1003,23,47\r\n"                        // CRLF
+        "-60,5,6\n"                             // before the epoch
+        "\n"                                    // blank, neither read nor skipped
+        "1004,24\n"                             // short row
+        "1005,25,48,99\n"                       // extra column
+        "1006,4294967296,50\n"                  // temp past UINT32_MAX
+        "1007,4294967295,4294967295\n"          // largest values that fit
+        "10x8,26,51\n"                          // malformed timestamp
+        "1009,,52\n"                            // empty field
+        "1010,27,53";                           // no final newline
+    int failures = 0;
+
+    FILE* in = fmemopen((void*)log, sizeof(log) - 1, "r");
+    collect_t out = {.accept = (size_t)-1};
+    ingest_stats_t stats;
+    failures += test_check(in != NULL && ingest_stream(in, INGEST_CSV, collect, &out, &stats) == 0, "ingest_stream");
+    if (in != NULL) fclose(in);
+
+    failures += test_check(stats.readings == 7 && out.count == 7, "CSV readings: %zu, want 7", stats.readings);
+    failures += test_check(stats.skipped == 6, "CSV skipped: %zu, want 6", stats.skipped);
+    if (out.count == 7) {
+        failures += test_check(same(&out.reads[0], 1000, 21, 45), "plain row");
+        failures += test_check(same(&out.reads[1], 1001, 21, 45), "fractions truncated");
+        failures += test_check(same(&out.reads[2], 1002, 22, 46), "padding trimmed");
+        failures += test_check(same(&out.reads[3], 1003, 23, 47), "CRLF row");
+        failures += test_check(same(&out.reads[4], -60, 5, 6), "negative timestamp");
+        failures += test_check(same(&out.reads[5], 1007, UINT32_MAX, UINT32_MAX), "UINT32_MAX values");
+        failures += test_check(same(&out.reads[6], 1010, 27, 53), "row without a newline");
+    }
+    return failures;
+}
+
+// A sink that stops the stream leaves the readings of the batch it refused uncounted
+static int run_rejected(void) {
+    static char log[3 * INGEST_BATCH_SIZE * 8];
+    size_t len = 0;
+    int failures = 0;
+
+    for (int i = 0; i < 3 * INGEST_BATCH_SIZE; i++) {
+        len += (size_t)snprintf(log + len, sizeof(log) - len, "%d,1,2\n", i % 1000);
+    }
+    FILE* in = fmemopen(log, len, "r");
+    collect_t out = {.accept = 1};
+    ingest_stats_t stats;
+    failures += test_check(in != NULL && ingest_stream(in, INGEST_CSV, collect, &out, &stats) == 0,
+                           "ingest_stream with a stopping sink");
+    if (in != NULL) fclose(in);
+    failures += test_check(out.taken == INGEST_BATCH_SIZE && stats.readings == out.taken,
+                           "readings counted after a stop: %zu, sink took %zu", stats.readings, out.taken);
+    return failures;
+}
+
+static int run_binary(void) {
+    temp_humid_data_t data[3] = {{-5, 1, 2}, {0, 3, 4}, {1700000000, UINT32_MAX, 7}};
+    char buf[3 * INGEST_RECORD_SIZE + 5];
+    int failures = 0;
+
+    FILE* out = fmemopen(buf, sizeof(buf), "w");
+    failures += test_check(out != NULL && ingest_write(out, INGEST_BINARY, data, 3) == 0, "ingest_write");
+    if (out != NULL) fclose(out);
+    memset(buf + 3 * INGEST_RECORD_SIZE, 0x5a, 5);      // truncated fourth record
+
+    FILE* in = fmemopen(buf, sizeof(buf), "r");
+    collect_t got = {.accept = (size_t)-1};
+    ingest_stats_t stats;
+    failures += test_check(in != NULL && ingest_stream(in, INGEST_BINARY, collect, &got, &stats) == 0,
+                           "binary ingest_stream");
+    if (in != NULL) fclose(in);
+    failures += test_check(stats.readings == 3 && stats.skipped == 1, "binary readings %zu, skipped %zu",
+                           stats.readings, stats.skipped);
+    for (size_t i = 0; i < got.count && i < 3; i++) {
+        failures += test_check(same(&got.reads[i], data[i].timestamp, data[i].temp, data[i].humid),
+                               "binary record %zu", i);
+    }
+    return failures;
+}
+
+static int run_tree(void) {
+    static const char log[] = "3,30,31\n1,10,11\nbad\n2,20,21\n1,12,13\n";
+    bst_arena_ptr_t arena = create_arena(0);
+    bst_node_ptr_t tree = NULL;
+    ingest_stats_t stats;
+    int failures = 0;
+
+    FILE* in = fmemopen((void*)log, sizeof(log) - 1, "r");
+    failures += test_check(in != NULL && ingest_into_tree(in, INGEST_CSV, &tree, arena, &stats) == 0,
+                           "ingest_into_tree");
+    if (in != NULL) fclose(in);
+    failures += test_check(stats.readings == 4 && stats.skipped == 1, "tree readings %zu, skipped %zu",
+                           stats.readings, stats.skipped);
+
+    test_order_t order = TEST_ORDER_INIT;
+    traverse_in_order(tree, test_check_order, &order);
+    failures += test_check(order.count == 4 && order.ordered, "tree holds every reading in order");
+    destroy_arena(arena);
+    return failures;
+}
+
+int main(void) {
+    int failures = 0;
+
+    failures += run_csv();
+    failures += run_rejected();
+    failures += run_binary();
+    failures += run_tree();
+    return test_finish(failures, "ingest");
+}
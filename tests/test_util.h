@@ -0,0 +1,76 @@
+/**
+* test_util.h - Shared helpers for the ctest programs in tests/
+ *
+ * @file:               test_util.h
+ * @author:            	Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Failure reporting and an in-order visitor shared by the test programs.  Each
+ * test counts its failures with test_check() and exits through test_finish().
+ *
+ */
+
+#ifndef _TEST_UTIL_H
+#define _TEST_UTIL_H
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "bst.h"
+
+// Visitor state for test_check_order(): counts readings and notes any out of order
+typedef struct test_order {
+    time_t last;
+    size_t count;
+    int ordered;
+} test_order_t;
+
+#define TEST_ORDER_INIT {0, 0, 1}
+
+/**
+ * @brief Prints "FAIL: " and the formatted message unless ok holds.
+ *
+ * @return int 0 if ok, 1 otherwise, to add to a failure count.
+ */
+static inline int test_check(int ok, const char* fmt, ...) {
+    if (!ok) {
+        va_list args;
+        va_start(args, fmt);
+        printf("FAIL: ");
+        vprintf(fmt, args);
+        printf("\n");
+        va_end(args);
+    }
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Visitor that counts readings and clears ordered if timestamps ever decrease.
+ *
+ * @param ctx A test_order_t, set up with TEST_ORDER_INIT.
+ */
+static inline int test_check_order(const temp_humid_data_t* data, void* ctx) {
+    test_order_t* order = (test_order_t*)ctx;
+    if (order->count > 0 && data->timestamp < order->last) order->ordered = 0;
+    order->last = data->timestamp;
+    order->count++;
+    return 0;
+}
+
+/**
+ * @brief Prints a one-line summary and returns the exit status for main().
+ *
+ * @param failures Number of failed checks.
+ * @param what What was checked, e.g. "AVL".
+ */
+static inline int test_finish(int failures, const char* what) {
+    if (failures == 0) {
+        printf("All %s checks passed\n", what);
+    } else {
+        printf("%s checks failed (%d)\n", what, failures);
+    }
+    return failures == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,144 @@
+/**
+ * test_wal_replay.c - write-ahead log replay after a torn or corrupt tail
+ *
+ * @file:               test_wal_replay.c
+ * @author:             Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Writes a log of several committed blocks, then cuts it mid-block or flips a
+ * byte in its last block, as a crash would leave it.  Checks that wal_replay()
+ * recovers every intact block, cuts the log back to them, and that appending after
+ * the replay and replaying again gives back every surviving reading.  Exits non-zero
+ * on failure.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "wal.h"
+#include "ingest.h"
+#include "test_util.h"
+
+#define BLOCK_READS     10      // readings per committed block
+#define NUM_BLOCKS      3
+#define BLOCK_BYTES     (WAL_HEADER_SIZE + BLOCK_READS * INGEST_RECORD_SIZE)
+
+static long file_size(const char* path) {
+    struct stat st;
+    return (stat(path, &st) == 0) ? (long)st.st_size : -1;
+}
+
+// Writes NUM_BLOCKS blocks of BLOCK_READS readings, timestamps 0 .. NUM_BLOCKS*BLOCK_READS-1
+static int write_log(const char* path) {
+    wal_ptr_t wal = wal_open(path, 0);
+    if (wal == NULL) return -1;
+    for (int b = 0; b < NUM_BLOCKS; b++) {
+        temp_humid_data_t block[BLOCK_READS];
+        for (int i = 0; i < BLOCK_READS; i++) {
+            int ts = b * BLOCK_READS + i;
+            block[i] = (temp_humid_data_t){ts, (uint32_t)ts + 100, (uint32_t)ts + 200};
+        }
+        if (wal_append(wal, block, BLOCK_READS) != 0 || wal_commit(wal) != 0) {
+            wal_close(wal);
+            return -1;
+        }
+    }
+    return wal_close(wal);
+}
+
+// Replays path into a fresh tree and checks it holds exactly timestamps 0 .. readings-1
+static int replay_check(const char* path, size_t readings, uint64_t truncated, const char* damage) {
+    bst_arena_ptr_t arena = create_arena(0);
+    bst_node_ptr_t tree = NULL;
+    wal_replay_stats_t stats;
+    int failures = 0;
+
+    failures += test_check(wal_replay(path, &tree, arena, &stats) == 0, "wal_replay succeeds (%s)", damage);
+    failures += test_check(stats.readings == readings, "readings recovered (%s)", damage);
+    failures += test_check(stats.truncated == truncated, "bytes truncated (%s)", damage);
+    failures += test_check(((tree == NULL) ? 0 : tree->agg.count) == readings, "tree size (%s)", damage);
+    for (size_t ts = 0; ts < readings; ts++) {
+        bst_node_ptr_t node = search_tree(tree, (time_t)ts);
+        if (node == NULL || node->data.temp != ts + 100 || node->data.humid != ts + 200) {
+            failures += test_check(0, "reading %zu after replay (%s)", ts, damage);
+            break;
+        }
+    }
+    destroy_arena(arena);
+    return failures;
+}
+
+static int run_case(const char* path, int corrupt) {
+    const char* damage = corrupt ? "corrupt last block" : "torn last block";
+    int failures = 0;
+
+    unlink(path);
+    if (write_log(path) != 0) {
+        return test_check(0, "write_log (%s)", damage);
+    }
+    failures += test_check(file_size(path) == NUM_BLOCKS * BLOCK_BYTES, "log size (%s)", damage);
+
+    // Damage the last block the way a crash mid-write would
+    uint64_t lost;
+    if (corrupt) {
+        FILE* f = fopen(path, "r+b");
+        fseek(f, (NUM_BLOCKS - 1) * BLOCK_BYTES + WAL_HEADER_SIZE + 3, SEEK_SET);
+        int c = fgetc(f);
+        fseek(f, -1, SEEK_CUR);
+        fputc(c ^ 0x40, f);
+        fclose(f);
+        lost = BLOCK_BYTES;
+    } else {
+        if (truncate(path, NUM_BLOCKS * BLOCK_BYTES - 7) != 0) {
+            return test_check(0, "truncate (%s)", damage);
+        }
+        lost = BLOCK_BYTES - 7;
+    }
+
+    size_t intact = (NUM_BLOCKS - 1) * BLOCK_READS;
+    failures += replay_check(path, intact, lost, damage);
+    failures += test_check(file_size(path) == (NUM_BLOCKS - 1) * BLOCK_BYTES, "log cut to the intact blocks (%s)",
+                           damage);
+
+    // A second replay finds nothing left to cut
+    failures += replay_check(path, intact, 0, damage);
+
+    // Appends after recovery follow straight on from the intact blocks
+    wal_ptr_t wal = wal_open(path, 0);
+    temp_humid_data_t more[BLOCK_READS];
+    for (int i = 0; i < BLOCK_READS; i++) {
+        size_t ts = intact + i;
+        more[i] = (temp_humid_data_t){(time_t)ts, (uint32_t)ts + 100, (uint32_t)ts + 200};
+    }
+    failures += test_check(wal != NULL && wal_append(wal, more, BLOCK_READS) == 0 && wal_close(wal) == 0,
+                           "append after replay (%s)", damage);
+    failures += replay_check(path, intact + BLOCK_READS, 0, damage);
+
+    unlink(path);
+    return failures;
+}
+
+int main(void) {
+    char dir[] = "/tmp/test_wal_XXXXXX";
+    char path[64];
+    int failures = 0;
+
+    if (mkdtemp(dir) == NULL) {
+        perror("mkdtemp");
+        return 1;
+    }
+    snprintf(path, sizeof(path), "%s/readings.wal", dir);
+
+    failures += run_case(path, 0);
+    failures += run_case(path, 1);
+
+    // A missing log replays as empty
+    failures += replay_check(path, 0, 0, "missing log");
+
+    unlink(path);
+    rmdir(dir);
+    return test_finish(failures, "write-ahead log");
+}
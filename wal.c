@@ -0,0 +1,263 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include "wal.h"
+#include "ingest.h"
+#include "fsutil.h"
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#endif
+
+#define WAL_BLOCK_BYTES (WAL_HEADER_SIZE + WAL_BLOCK_RECORDS * INGEST_RECORD_SIZE)
+
+static void put_u32(unsigned char* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = (unsigned char)(v >> (8 * i));
+}
+
+static uint32_t get_u32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// The CRC covers the record count and the records, everything after it in the block
+static uint32_t block_crc(const unsigned char* block, size_t count) {
+    uint32_t crc = wal_crc32c(0, block + 4, 4);
+    return wal_crc32c(crc, block + WAL_HEADER_SIZE, count * INGEST_RECORD_SIZE);
+}
+
+// write() until done, retrying short writes and interrupts
+static int write_all(int fd, const unsigned char* buf, size_t len) {
+    while (len > 0) {
+        ssize_t written = write(fd, buf, len);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        buf += written;
+        len -= (size_t)written;
+    }
+    return 0;
+}
+
+static int flush_block(wal_ptr_t wal) {
+    if (wal->count == 0) return 0;
+
+    put_u32(wal->block, WAL_MAGIC);
+    put_u32(wal->block + 4, (uint32_t)wal->count);
+    put_u32(wal->block + 8, block_crc(wal->block, wal->count));
+    put_u32(wal->block + 12, 0);
+    if (write_all(wal->fd, wal->block, WAL_HEADER_SIZE + wal->count * INGEST_RECORD_SIZE) != 0) {
+        return -1;
+    }
+    wal->unsynced += wal->count;
+    wal->count = 0;
+    return 0;
+}
+
+wal_ptr_t wal_open(const char* path, size_t sync_every) {
+    struct stat st;
+    int created = (stat(path, &st) != 0);
+
+    wal_ptr_t wal = (wal_ptr_t)malloc(sizeof(wal_t));
+    unsigned char* block = (unsigned char*)malloc(WAL_BLOCK_BYTES);
+    if (wal == NULL || block == NULL) {
+        printf("Error! Failed to allocate memory for function[wal_open].\n");
+        free(wal);
+        free(block);
+        return NULL;
+    }
+
+    wal->fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (wal->fd < 0 || (created && sync_parent_dir(path) != 0)) {
+        if (wal->fd >= 0) close(wal->fd);
+        free(block);
+        free(wal);
+        return NULL;
+    }
+    wal->block = block;
+    wal->count = 0;
+    wal->sync_every = sync_every;
+    wal->unsynced = 0;
+    return wal;
+}
+
+int wal_append(wal_ptr_t wal, const temp_humid_data_t* data, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        ingest_encode(&data[i], wal->block + WAL_HEADER_SIZE + wal->count * INGEST_RECORD_SIZE);
+        wal->count++;
+        if (wal->count == WAL_BLOCK_RECORDS && flush_block(wal) != 0) {
+            return -1;
+        }
+        if (wal->sync_every != 0 && wal->unsynced + wal->count >= wal->sync_every && wal_commit(wal) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int wal_commit(wal_ptr_t wal) {
+    if (flush_block(wal) != 0) return -1;
+    if (wal->unsynced > 0) {
+        if (fdatasync(wal->fd) != 0) return -1;
+        wal->unsynced = 0;
+    }
+    return 0;
+}
+
+int wal_close(wal_ptr_t wal) {
+    if (wal == NULL) return 0;
+
+    int rtn = wal_commit(wal);
+    if (close(wal->fd) != 0) rtn = -1;
+    free(wal->block);
+    free(wal);
+    return rtn;
+}
+
+int wal_replay(const char* path, bst_node_ptr_t* tree, bst_arena_ptr_t arena, wal_replay_stats_t* stats) {
+    wal_replay_stats_t result = {0, 0, 0};
+
+    FILE* in = fopen(path, "rb");
+    if (in == NULL) {
+        if (stats != NULL) *stats = result;
+        return (errno == ENOENT) ? 0 : -1;
+    }
+    unsigned char* block = (unsigned char*)malloc(WAL_BLOCK_BYTES);
+    if (block == NULL) {
+        printf("Error! Failed to allocate memory for function[wal_replay].\n");
+        fclose(in);
+        return -1;
+    }
+
+    // Into an empty tree the readings are staged and bulk built, which is linear
+    // for a log written in time order; otherwise they are inserted as they are read
+    temp_humid_data_t* staged = NULL;
+    size_t staged_cap = 0;
+    int bulk = (*tree == NULL);
+
+    // Read block by block; the first block that is short, malformed or fails its
+    // CRC marks the end of what was durably written
+    uint64_t valid = 0;
+    int failed = 0;
+    while (!failed) {
+        if (fread(block, 1, WAL_HEADER_SIZE, in) != WAL_HEADER_SIZE) break;
+        uint32_t count = get_u32(block + 4);
+        if (get_u32(block) != WAL_MAGIC || count == 0 || count > WAL_BLOCK_RECORDS) break;
+        size_t payload = (size_t)count * INGEST_RECORD_SIZE;
+        if (fread(block + WAL_HEADER_SIZE, 1, payload, in) != payload) break;
+        if (get_u32(block + 8) != block_crc(block, count)) break;
+
+        if (bulk && result.readings + count > staged_cap) {
+            size_t cap = (staged_cap == 0) ? WAL_BLOCK_RECORDS : 2 * staged_cap;
+            temp_humid_data_t* grown = (cap <= INT32_MAX) ? (temp_humid_data_t*)realloc(staged, cap * sizeof(temp_humid_data_t)) : NULL;
+            if (grown == NULL) {
+                // out of room to stage: insert what is staged and carry on one by one
+                for (size_t i = 0; i < result.readings && !failed; i++) {
+                    failed = insert_node_policy(tree, staged[i], arena, BST_DUP_CHAIN) < 0;
+                }
+                free(staged);
+                staged = NULL;
+                bulk = 0;
+            } else {
+                staged = grown;
+                staged_cap = cap;
+            }
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            temp_humid_data_t data;
+            ingest_decode(block + WAL_HEADER_SIZE + (size_t)i * INGEST_RECORD_SIZE, &data);
+            if (bulk) {
+                staged[result.readings + i] = data;
+            } else if (insert_node_policy(tree, data, arena, BST_DUP_CHAIN) < 0) {
+                failed = 1;
+                break;
+            }
+        }
+        result.readings += count;
+        result.blocks++;
+        valid += WAL_HEADER_SIZE + payload;
+    }
+    if (!failed && bulk && result.readings > 0) {
+        *tree = create_tree_sorted(staged, (int)result.readings, arena);
+        failed = (*tree == NULL);
+    }
+    free(staged);
+    int read_error = ferror(in);
+    fclose(in);
+    free(block);
+
+    // Readings that did not make it into the tree are still only in the log, so
+    // leave it untouched rather than truncate after a partial replay
+    if (read_error || failed) return -1;
+
+    // Cut the torn tail so new blocks follow the last intact one
+    struct stat st;
+    if (stat(path, &st) != 0) return -1;
+    if ((uint64_t)st.st_size > valid) {
+        result.truncated = (uint64_t)st.st_size - valid;
+        int fd = open(path, O_WRONLY);
+        if (fd < 0 || ftruncate(fd, (off_t)valid) != 0 || fsync(fd) != 0) {
+            if (fd >= 0) close(fd);
+            return -1;
+        }
+        close(fd);
+    }
+    if (stats != NULL) *stats = result;
+    return 0;
+}
+
+#if !(defined(__SSE4_2__) && defined(__x86_64__))
+// Software CRC-32C, eight table lookups per 8 bytes (slicing-by-8)
+static uint32_t crc_table[8][256];
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+static void build_crc_table(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1)));
+        }
+        crc_table[0][i] = crc;
+    }
+    for (uint32_t i = 0; i < 256; i++) {
+        for (int t = 1; t < 8; t++) {
+            crc_table[t][i] = (crc_table[t - 1][i] >> 8) ^ crc_table[0][crc_table[t - 1][i] & 0xFF];
+        }
+    }
+}
+#endif
+
+uint32_t wal_crc32c(uint32_t crc, const void* buf, size_t len) {
+    const unsigned char* p = (const unsigned char*)buf;
+    crc = ~crc;
+
+#if defined(__SSE4_2__) && defined(__x86_64__)
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc = (uint32_t)_mm_crc32_u64(crc, word);
+    }
+    for (; len > 0; p++, len--) {
+        crc = _mm_crc32_u8(crc, *p);
+    }
+#else
+    pthread_once(&crc_table_once, build_crc_table);
+    for (; len >= 8; p += 8, len -= 8) {
+        uint32_t lo = crc ^ get_u32(p);
+        uint32_t hi = get_u32(p + 4);
+        crc = crc_table[7][lo & 0xFF] ^ crc_table[6][(lo >> 8) & 0xFF]
+            ^ crc_table[5][(lo >> 16) & 0xFF] ^ crc_table[4][lo >> 24]
+            ^ crc_table[3][hi & 0xFF] ^ crc_table[2][(hi >> 8) & 0xFF]
+            ^ crc_table[1][(hi >> 16) & 0xFF] ^ crc_table[0][hi >> 24];
+    }
+    for (; len > 0; p++, len--) {
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ *p) & 0xFF];
+    }
+#endif
+    return ~crc;
+}
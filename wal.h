@@ -0,0 +1,109 @@
+/**
+* wal.h - Header file for the write-ahead log of sensor readings
+ *
+ * @file:               wal.h
+ * @author:            	Crow Crossman (crowc.edu)
+ * @date:               16-October-2026
+ *
+ * @brief
+ * Append-only log that makes readings durable before (or while) they go into the
+ * in-memory tree.  Readings are packed into blocks of up to WAL_BLOCK_RECORDS
+ * binary records (the ingest.h record format), each block carrying a CRC-32C of its
+ * contents.  Many readings share one fdatasync() (group commit): a reading is
+ * durable once wal_commit() returns, or once sync_every readings have been appended
+ * after it.
+ *
+ * After a crash the log may end in a torn block.  wal_replay() loads every intact
+ * block into a tree and cuts the log back to the last one, so reopening it with
+ * wal_open() appends right after the recovered readings.
+ *
+ * A log has one writer at a time.
+ *
+ */
+
+#ifndef _WAL_H
+#define _WAL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bst.h"
+
+#define WAL_MAGIC           0x4C415748u     // "HWAL" in little-endian byte order
+#define WAL_HEADER_SIZE     16              // magic, record count, CRC, reserved
+#define WAL_BLOCK_RECORDS   4096            // readings per full block
+
+// Open log
+typedef struct wal {
+    int fd;
+    unsigned char *block;   // block being filled: header space + WAL_BLOCK_RECORDS records
+    size_t count;           // readings in block
+    size_t sync_every;      // readings per automatic fdatasync(), 0 for wal_commit() only
+    size_t unsynced;        // readings written to the file since the last fdatasync()
+} wal_t, *wal_ptr_t;
+
+typedef struct wal_replay_stats {
+    size_t readings;        // readings inserted into the tree
+    size_t blocks;          // intact blocks read
+    uint64_t truncated;     // bytes of torn or corrupt tail cut from the log
+} wal_replay_stats_t;
+
+/**
+ * @brief Opens a log for appending, creating it if needed.
+ *
+ * @param path Log file.  Run wal_replay() on an existing log first so a torn tail is removed.
+ * @param sync_every Readings per automatic group commit, 0 to sync only in wal_commit().
+ * @return wal_ptr_t The open log, or NULL on failure.
+ */
+wal_ptr_t wal_open(const char* path, size_t sync_every);
+
+/**
+ * @brief Appends readings to the log.  Full blocks are written at once; the last
+ * partial block waits for more readings or the next commit.
+ *
+ * @param wal The open log.
+ * @param data Readings to append.
+ * @param n Number of readings.
+ * @return int 0 on success, -1 on a write or sync error.
+ */
+int wal_append(wal_ptr_t wal, const temp_humid_data_t* data, size_t n);
+
+/**
+ * @brief Writes any buffered readings and syncs them to disk.
+ *
+ * @param wal The open log.
+ * @return int 0 once every appended reading is durable, -1 on error.
+ */
+int wal_commit(wal_ptr_t wal);
+
+/**
+ * @brief Commits and closes a log.
+ *
+ * @param wal The open log (NULL is ignored).
+ * @return int 0 on success, -1 if the final commit failed.
+ */
+int wal_close(wal_ptr_t wal);
+
+/**
+ * @brief Inserts every reading of a log into a tree, in logged order, and truncates
+ * a torn or corrupt tail.  A missing log counts as empty.
+ *
+ * @param path Log file.
+ * @param tree Pointer to the root pointer of the tree.
+ * @param arena Arena for the new nodes, or NULL for malloc.
+ * @param stats Receives counts, may be NULL.
+ * @return int 0 on success, -1 if the log could not be read or repaired or its
+ * readings could not all be inserted.  A failed replay leaves the log untouched.
+ */
+int wal_replay(const char* path, bst_node_ptr_t* tree, bst_arena_ptr_t arena, wal_replay_stats_t* stats);
+
+/**
+ * @brief CRC-32C (Castagnoli) of a buffer, as stored in each block header.
+ *
+ * @param crc 0 to start, or the CRC of the preceding bytes to continue.
+ * @param buf Bytes to add.
+ * @param len Number of bytes.
+ * @return uint32_t The updated CRC.
+ */
+uint32_t wal_crc32c(uint32_t crc, const void* buf, size_t len);
+
+#endif